@@ -1,9 +1,22 @@
 #version 450
 
 layout (location = 0) in vec2 texCoord;
-uniform sampler u_tex;
+layout (binding = 0) uniform sampler2D u_tex;
+layout (binding = 1) uniform sampler2D u_palette;
+// palette_mode 为 1 时 u_tex 是 R8G8（材质 id、颜色档），颜色从调色板第 palette_view 个视图中取
+layout (push_constant) uniform PushConstants {
+    int palette_mode;
+    int palette_view;
+    int rows_per_view;
+} pc;
 layout (location = 0) out vec4 frag_color;
 void main()
 {
-    frag_color = textureLod(u_tex, texCoord, 0.0);
+    vec4 texel = textureLod(u_tex, texCoord, 0.0);
+    if (pc.palette_mode == 0) {
+        frag_color = texel;
+        return;
+    }
+    ivec2 cell = ivec2(round(texel.rg * 255.0));
+    frag_color = texelFetch(u_palette, ivec2(cell.x, pc.palette_view * pc.rows_per_view + cell.y), 0);
 }
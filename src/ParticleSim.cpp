@@ -1,17 +1,41 @@
 // main.cpp
 #include "ParticleSim.h"
+#include <chrono>
+
 #include "Utilities.h"
+#include "sim/margolus.h"
+#include "sim/simd.h"
+#include "sim/material_registry.h"
+#include "sim/movement_kernels.h"
+#include "sim/move_intent.h"
+#include "sim/powder_bitboard.h"
 
 ParticleSimulator::ParticleSimulator(int texture_wdith, int texture_height) {
     this->m_textureWidth = texture_wdith;
     this->m_textureHeight = texture_height;
-    this->m_particles = new std::vector<Particle>(texture_wdith * texture_height, Particle{MAT_EMPTY});
-    color_buffer = new Color[texture_wdith * texture_height];
+    m_stride = texture_wdith + 2 * SIM_GRID_PADDING;
+    m_grid.resize((size_t)m_stride * (texture_height + 2 * SIM_GRID_PADDING));
+    build_ghost_border();
+    m_occupancy.resize(texture_wdith, texture_height);
+    color_buffer = new Color[texture_wdith * texture_height]();
+    m_palette_cells = new PaletteCell[texture_wdith * texture_height]();
+
+    m_materials = new MaterialRegistry();
+    load_materials("assets/materials/materials.txt");
+
+    build_chunk_phases();
+    set_thread_count(0);
+    set_seed(m_world_seed);
 }
 ParticleSimulator::~ParticleSimulator() {
-    delete m_particles;
-    delete color_buffer;
-    m_particles = nullptr;
+    delete m_thread_pool;
+    delete m_materials;
+    delete[] m_chunks;
+    delete[] m_move_claims;
+    delete[] color_buffer;
+    color_buffer = nullptr;
+    delete[] m_palette_cells;
+    m_palette_cells = nullptr;
 }
 
 void ParticleSimulator::init() {
@@ -19,290 +43,752 @@ void ParticleSimulator::init() {
 }
 
 void ParticleSimulator::resetParticles() {
-    std::fill(m_particles->begin(), m_particles->end(), Particle{MAT_EMPTY});
-}
-
-void ParticleSimulator::update(float deltaTime) {
-    m_deltaTime = deltaTime; // Update particles
+    m_grid.clear();
+    build_ghost_border();
+    m_occupancy.clear();
+    for (int32_t i = 0; i < m_chunkCountX * m_chunkCountY; ++i) {
+        release_chunk_claims(i % m_chunkCountX, i / m_chunkCountX);
+        m_chunks[i].reset();
+    }
+    m_accumulator = 0.f;
+    m_all_changed = true;
+    m_output_stale = true;
+    refresh_output();
+}
+
+void ParticleSimulator::set_output(SimOutput output) {
+    if (output == m_output) return;
+    m_output = output;
+
+    // 另一种格式的缓冲区在切换前没有维护
+    m_output_stale = true;
+    m_all_changed = true;
+}
+
+void ParticleSimulator::refresh_output() {
+    uint32_t chunk_count = (uint32_t)(m_chunkCountX * m_chunkCountY);
+    if (m_output_stale) {
+        for (uint32_t i = 0; i < chunk_count; ++i) {
+            m_chunks[i].stale.clear();
+            m_chunks[i].stale.add(0, 0, INT32_MAX, INT32_MAX);
+        }
+        m_output_stale = false;
+    }
+
+    // 每个区块只生成自己范围内的输出，互不重叠，可以并行
+    const Color* lut = &m_materials->table().colors[0][0];
+    const SimKernels& kernels = simd_kernels();
+    m_thread_pool->parallel_for(chunk_count, [this, lut, &kernels](uint32_t chunk) {
+        SimChunk& c = m_chunks[chunk];
+        c.add_pending(c.stale);
+        if (c.stale.empty()) return;
+
+        int32_t cx = (int32_t)chunk % m_chunkCountX;
+        int32_t cy = (int32_t)chunk / m_chunkCountX;
+        int32_t x0 = std::max(c.stale.min_x, cx * SIM_CHUNK_SIZE);
+        int32_t y0 = std::max(c.stale.min_y, cy * SIM_CHUNK_SIZE);
+        int32_t x1 = std::min({c.stale.max_x, cx * SIM_CHUNK_SIZE + SIM_CHUNK_SIZE - 1, m_textureWidth - 1});
+        int32_t y1 = std::min({c.stale.max_y, cy * SIM_CHUNK_SIZE + SIM_CHUNK_SIZE - 1, m_textureHeight - 1});
+        c.stale.clear();
+
+        for (int32_t y = y0; y <= y1; ++y) {
+            int32_t idx = compute_idx(x0, y);
+            int32_t out = y * m_textureWidth + x0;
+            if (m_output == SIM_OUTPUT_PALETTE) {
+                kernels.pack_palette_row(&m_grid.id[idx], &m_grid.variation[idx], m_palette_cells + out, x1 - x0 + 1);
+            } else {
+                kernels.colorize_row(&m_grid.id[idx], &m_grid.variation[idx], lut, color_buffer + out, x1 - x0 + 1);
+            }
+        }
+    });
+}
+
+void ParticleSimulator::take_changed_regions(std::vector<SimRect>& out) {
+    out.clear();
+    int32_t chunk_count = m_chunkCountX * m_chunkCountY;
+    if (m_all_changed) {
+        out.push_back(SimRect { 0, 0, m_textureWidth - 1, m_textureHeight - 1 });
+        for (int32_t i = 0; i < chunk_count; ++i) m_chunks[i].changed.clear();
+        m_all_changed = false;
+        return;
+    }
+
+    for (int32_t i = 0; i < chunk_count; ++i) {
+        SimChunk& c = m_chunks[i];
+        // 最后一个 tick 和笔刷的写入还留在下一帧的脏矩形里，也要算上
+        c.add_pending(c.changed);
+        if (!c.changed.empty()) {
+            out.push_back(SimRect { c.changed.min_x, c.changed.min_y, c.changed.max_x, c.changed.max_y });
+        }
+        c.changed.clear();
+    }
+}
+
+uint32_t ParticleSimulator::update(float deltaTime) {
+    if (!m_run_simulation) {
+        m_accumulator = 0.f;
+        return 0;
+    }
+
+    // 快进：在墙钟预算内尽量多跑 tick，至少跑一个
+    if (m_turbo) {
+        using clock = std::chrono::steady_clock;
+        auto deadline = clock::now() + std::chrono::microseconds((int64_t)(m_turbo_budget_ms * 1000.f));
+        uint32_t ticks = 0;
+        do {
+            step();
+            ++ticks;
+        } while (clock::now() < deadline);
+        m_accumulator = 0.f;
+        refresh_output();
+        return ticks;
+    }
+
+    // 固定步长：累积帧时间，每满一个 tick 执行一次；
+    // 追赶超过 m_max_substeps 时丢弃积压，避免卡顿后越追越慢
+    float tick = 1.f / m_tick_rate;
+    m_accumulator += deltaTime;
+    uint32_t ticks = 0;
+    while (m_accumulator >= tick && ticks < m_max_substeps) {
+        step();
+        m_accumulator -= tick;
+        ++ticks;
+    }
+    if (ticks == m_max_substeps) m_accumulator = std::min(m_accumulator, tick);
+    // 多个 tick 只生成一次输出
+    if (ticks > 0) refresh_output();
+    return ticks;
+}
+
+void ParticleSimulator::step() {
+    m_deltaTime = 1.f / m_tick_rate;
+    update_particle_sim();
+}
+
+int32_t ParticleSimulator::awake_chunk_count() const {
+    int32_t count = 0;
+    for (int32_t i = 0; i < m_chunkCountX * m_chunkCountY; ++i) count += m_chunks[i].is_awake(m_chunk_sleep_frames);
+    return count;
+}
+
+void ParticleSimulator::paint_circle(int32_t x, int32_t y, int32_t radius, uint8_t id, float density) {
+    // 先把外接正方形裁剪到世界内，循环里不需要边界判断
+    int32_t dy0 = std::max(-radius, -y), dy1 = std::min(radius, m_textureHeight - 1 - y);
+    int32_t dx0 = std::max(-radius, -x), dx1 = std::min(radius, m_textureWidth - 1 - x);
+    for (int32_t dy = dy0; dy <= dy1; ++dy) {
+        for (int32_t dx = dx0; dx <= dx1; ++dx) {
+            if (dx * dx + dy * dy > radius * radius) continue;
+            if (density < 1.f && Utilities::random_unit() >= density) continue;
+            write_data(compute_idx(x + dx, y + dy), create_particle(id));
+        }
+    }
+}
+
+void ParticleSimulator::paint_rect(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint8_t id, float density) {
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, m_textureWidth - 1);
+    y1 = std::min(y1, m_textureHeight - 1);
+    for (int32_t y = y0; y <= y1; ++y) {
+        for (int32_t x = x0; x <= x1; ++x) {
+            if (density < 1.f && Utilities::random_unit() >= density) continue;
+            write_data(compute_idx(x, y), create_particle(id));
+        }
+    }
+}
+
+void ParticleSimulator::export_packed(std::vector<PackedCell>& cells) const {
+    cells.resize((size_t)m_textureWidth * m_textureHeight);
+    for (int32_t y = 0; y < m_textureHeight; ++y) {
+        for (int32_t x = 0; x < m_textureWidth; ++x) {
+            int32_t idx = compute_idx(x, y);
+            uint8_t id = m_grid.id[idx];
+            uint8_t flags = m_grid.updated[idx] ? PACKED_FLAG_UPDATED : 0;
+            if (m_gravity_sign_table[id] != 0.f) {
+                int32_t ahead = idx + m_neighbor_offset[m_gravity_sign_table[id] > 0.f ? NEIGHBOR_DOWN : NEIGHBOR_UP];
+                if (m_displace_table[id].test(m_grid.id[ahead])) flags |= PACKED_FLAG_FREE_FALL;
+            }
+            cells[(size_t)y * m_textureWidth + x] = pack_cell(id, m_grid.variation[idx], m_grid.lifetime[idx],
+                                                              m_grid.velocity[idx], flags);
+        }
+    }
+}
+
+void ParticleSimulator::import_packed(const std::vector<PackedCell>& cells) {
+    const MaterialTable& table = m_materials->table();
+    int32_t count = std::min((int32_t)cells.size(), m_textureWidth * m_textureHeight);
+    for (int32_t i = 0; i < count; ++i) {
+        PackedCell c = cells[i];
+        Particle p{};
+        p.id = packed_id(c);
+        p.variation = std::min<uint8_t>(packed_variation(c), table.variation_count[p.id] - 1);
+        p.lifetime = packed_lifetime(c);
+        p.velocity = packed_velocity(c);
+        write_data(compute_idx(i % m_textureWidth, i / m_textureWidth), p);
+    }
+}
+
+bool ParticleSimulator::load_materials(const std::string& path) {
+    bool loaded = m_materials->load(path);
+    build_update_table();
+    // 颜色表可能变了，整个输出重新生成
+    m_output_stale = true;
+    m_all_changed = true;
+    return loaded;
+}
+
+void ParticleSimulator::build_update_table() {
+    // MaterialUpdate -> 成员函数，空格子和不需要更新的材质为 nullptr
+    static const UpdateFn kernels[UPDATE_KERNEL_COUNT] = {
+        nullptr,
+        &ParticleSimulator::update_sand,
+        &ParticleSimulator::update_water,
+        &ParticleSimulator::update_salt,
+        &ParticleSimulator::update_fire,
+        &ParticleSimulator::update_lava,
+        &ParticleSimulator::update_smoke,
+        &ParticleSimulator::update_ember,
+        &ParticleSimulator::update_steam,
+        &ParticleSimulator::update_gunpowder,
+        &ParticleSimulator::update_oil,
+        &ParticleSimulator::update_acid,
+        &ParticleSimulator::update_default,
+        nullptr,
+        &ParticleSimulator::update_movement<ARCHETYPE_POWDER, PowderTraits>,
+        &ParticleSimulator::update_movement<ARCHETYPE_LIQUID, LiquidTraits>,
+        &ParticleSimulator::update_movement<ARCHETYPE_GAS, GasTraits>,
+    };
+    // 与 kernels 一一对应，重力积分使用
+    static const MovementParams movement[UPDATE_KERNEL_COUNT] = {
+        k_static_movement,
+        movement_params<SandTraits>(),
+        movement_params<WaterTraits>(),
+        movement_params<SaltTraits>(),
+        movement_params<FireTraits>(),
+        movement_params<LavaTraits>(),
+        movement_params<SmokeTraits>(),
+        movement_params<EmberTraits>(),
+        movement_params<SteamTraits>(),
+        movement_params<GunpowderTraits>(),
+        movement_params<OilTraits>(),
+        movement_params<AcidTraits>(),
+        k_static_movement,
+        k_static_movement,
+        movement_params<PowderTraits>(),
+        movement_params<LiquidTraits>(),
+        movement_params<GasTraits>(),
+    };
+
+    const MaterialTable& table = m_materials->table();
+    for (int32_t id = 0; id < MATERIAL_MAX_COUNT; ++id) {
+        m_update_table[id] = kernels[table.update[id]];
+        m_phase_table[id] = table.phase[id];
+        m_gravity_sign_table[id] = movement[table.update[id]].gravity_sign;
+        m_max_speed_table[id] = movement[table.update[id]].max_speed;
+        m_bitboard_table[id] = movement[table.update[id]].bitboard;
+        m_column_run_table[id] = movement[table.update[id]].column_run;
+        m_decay_table[id] = movement[table.update[id]].decays;
+        m_margolus_class[id] = margolus_class((MaterialPhase)table.phase[id]);
+    }
+
+    // 置换关系由相态和密度决定：运动的材质都能进入空格，粉末和液体还能挤开气体、沉入比自己轻的液体。
+    // 幽灵格和未定义的 id 是固体，不在任何集合内
+    for (int32_t id = 0; id < MATERIAL_MAX_COUNT; ++id) {
+        MaterialMask& mask = m_displace_table[id];
+        mask = MaterialMask{};
+        uint8_t phase = table.phase[id];
+        if (phase != PHASE_POWDER && phase != PHASE_LIQUID && phase != PHASE_GAS) continue;
+        for (int32_t other = 0; other < MATERIAL_MAX_COUNT; ++other) {
+            uint8_t other_phase = table.phase[other];
+            bool sinks = phase != PHASE_GAS &&
+                         (other_phase == PHASE_GAS || (other_phase == PHASE_LIQUID && table.density[id] > table.density[other]));
+            if (other_phase == PHASE_EMPTY || sinks) mask.set((uint8_t)other);
+        }
+    }
+}
+
+void ParticleSimulator::build_ghost_border() {
+    // 邻居下标差只取决于行宽
+    m_neighbor_offset[NEIGHBOR_UP] = -m_stride;
+    m_neighbor_offset[NEIGHBOR_DOWN] = m_stride;
+    m_neighbor_offset[NEIGHBOR_LEFT] = -1;
+    m_neighbor_offset[NEIGHBOR_RIGHT] = 1;
+    m_neighbor_offset[NEIGHBOR_UP_LEFT] = -m_stride - 1;
+    m_neighbor_offset[NEIGHBOR_UP_RIGHT] = -m_stride + 1;
+    m_neighbor_offset[NEIGHBOR_DOWN_LEFT] = m_stride - 1;
+    m_neighbor_offset[NEIGHBOR_DOWN_RIGHT] = m_stride + 1;
+
+    // 边框填满幽灵格，世界内的格子不变
+    int32_t rows = m_textureHeight + 2 * SIM_GRID_PADDING;
+    for (int32_t py = 0; py < rows; ++py) {
+        uint8_t* row = &m_grid.id[(size_t)py * m_stride];
+        if (py < SIM_GRID_PADDING || py >= SIM_GRID_PADDING + m_textureHeight) {
+            std::fill(row, row + m_stride, mat_id_ghost);
+        } else {
+            std::fill(row, row + SIM_GRID_PADDING, mat_id_ghost);
+            std::fill(row + SIM_GRID_PADDING + m_textureWidth, row + m_stride, mat_id_ghost);
+        }
+    }
+}
+
+void ParticleSimulator::set_seed(uint64_t seed) {
+    m_world_seed = seed;
+    m_frame = 0;
+    // 模拟之外（例如笔刷）生成的粒子使用单独的随机流
+    Utilities::seed_random(random_key(seed, 0, UINT64_MAX));
+}
+
+void ParticleSimulator::set_thread_count(uint32_t count) {
+    if (count == 0) {
+        count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (m_thread_pool && m_thread_pool->thread_count() == count) return;
+
+    delete m_thread_pool;
+    m_thread_pool = new ThreadPool(count);
+}
+
+void ParticleSimulator::build_chunk_phases() {
+    m_chunkCountX = (m_textureWidth + SIM_CHUNK_SIZE - 1) / SIM_CHUNK_SIZE;
+    m_chunkCountY = (m_textureHeight + SIM_CHUNK_SIZE - 1) / SIM_CHUNK_SIZE;
+
+    delete[] m_chunks;
+    m_chunks = new SimChunk[m_chunkCountX * m_chunkCountY];
+
+    // 阶段 = (cx & 1) + 2 * (cy & 1)，同阶段的区块在两个方向上都互不相邻
+    for (int32_t i = 0; i < SIM_PHASE_COUNT; ++i) m_phase_chunks[i].clear();
+    for (int32_t cy = 0; cy < m_chunkCountY; ++cy) {
+        for (int32_t cx = 0; cx < m_chunkCountX; ++cx) {
+            int32_t phase = (cx & 1) + 2 * (cy & 1);
+            m_phase_chunks[phase].push_back((uint32_t)(cy * m_chunkCountX + cx));
+        }
+    }
+}
+
+Particle ParticleSimulator::create_particle(uint8_t id)
+{
+    // 颜色档和寿命都来自材质表
+    const MaterialTable& table = m_materials->table();
+    Particle p{};
+    p.id = id;
 
+    uint8_t variations = table.variation_count[id];
+    p.variation = variations > 1 ? (uint8_t)Utilities::random_val(0, variations - 1) : 0;
 
+    if (table.lifetime_max[id] > 0.f) {
+        p.lifetime = Utilities::interp_linear(table.lifetime_min[id], table.lifetime_max[id], Utilities::random_unit());
+    }
+    return p;
 }
 
 Particle ParticleSimulator::particle_empty()
 {
-    Particle p = {0};
-    p.id = mat_id_empty;
-    p.color = mat_col_empty;
-    return p;
+    return create_particle(mat_id_empty);
 }
 
 Particle ParticleSimulator::particle_sand()
 {
-    Particle p = {0};
-    p.id = mat_id_sand;
-    // Random sand color
-    float r = (float)(Utilities::random_val(0, 10)) / 10.f;
-    p.color.r = (uint8_t)(Utilities::interp_linear(0.8f, 1.f, r) * 255.f);
-    p.color.g = (uint8_t)(Utilities::interp_linear(0.5f, 0.6f, r) * 255.f);
-    p.color.b = (uint8_t)(Utilities::interp_linear(0.2f, 0.25f, r) * 255.f);
-    p.color.a = 255;
-    return p;
+    return create_particle(mat_id_sand);
 }
 
 Particle ParticleSimulator::particle_water()
 {
-    Particle p = {0};
-    p.id = mat_id_water;
-    float r = (float)(Utilities::random_val(0, 1)) / 2.f;
-    p.color.r = (uint8_t)(Utilities::interp_linear(0.1f, 0.15f, r) * 255.f);
-    p.color.g = (uint8_t)(Utilities::interp_linear(0.3f, 0.35f, r) * 255.f);
-    p.color.b = (uint8_t)(Utilities::interp_linear(0.7f, 0.8f, r) * 255.f);
-    p.color.a = 255;
-    return p;
+    return create_particle(mat_id_water);
 }
 
 Particle ParticleSimulator::particle_salt()
 {
-    Particle p = {0};
-    p.id = mat_id_salt;
-    float r = (float)(Utilities::random_val(0, 1)) / 2.f;
-    p.color.r = (uint8_t)(Utilities::interp_linear(0.9f, 1.0f, r) * 255.f);
-    p.color.g = (uint8_t)(Utilities::interp_linear(0.8f, 0.85f, r) * 255.f);
-    p.color.b = (uint8_t)(Utilities::interp_linear(0.8f, 0.9f, r) * 255.f);
-    p.color.a = 255;
-    return p;
+    return create_particle(mat_id_salt);
 }
 
 Particle ParticleSimulator::particle_wood()
 {
-    Particle p = {0};
-    p.id = mat_id_wood;
-    float r = (float)(Utilities::random_val(0, 1)) / 2.f;
-    p.color.r = (uint8_t)(Utilities::interp_linear(0.23f, 0.25f, r) * 255.f);
-    p.color.g = (uint8_t)(Utilities::interp_linear(0.15f, 0.18f, r) * 255.f);
-    p.color.b = (uint8_t)(Utilities::interp_linear(0.02f, 0.03f, r) * 255.f);
-    p.color.a = 255;
-    return p;
+    return create_particle(mat_id_wood);
 }
 
 Particle ParticleSimulator::particle_fire()
 {
-    Particle p = {0};
-    p.id = mat_id_fire;
-    p.color = mat_col_fire;
-    return p;
+    return create_particle(mat_id_fire);
 }
 
 Particle ParticleSimulator::particle_lava()
 {
-    Particle p = {0};
-    p.id = mat_id_lava;
-    p.color = mat_col_fire;
-    return p;
+    return create_particle(mat_id_lava);
 }
 
 Particle ParticleSimulator::particle_smoke()
 {
-    Particle p = {0};
-    p.id = mat_id_smoke;
-    p.color = mat_col_smoke;
-    return p;
+    return create_particle(mat_id_smoke);
 }
 
 Particle ParticleSimulator::particle_ember()
 {
-    Particle p = {0};
-	p.id = mat_id_ember;
-	p.color = mat_col_ember;
-	return p;
+    return create_particle(mat_id_ember);
 }
 
 Particle ParticleSimulator::particle_steam()
 {
-    Particle p = {0};
-    p.id = mat_id_steam;
-    p.color = mat_col_steam;
-    return p;
+    return create_particle(mat_id_steam);
 }
 
 Particle ParticleSimulator::particle_gunpowder()
 {
-    Particle p = {0};
-    p.id = mat_id_gunpowder;
-    float r = (float)(Utilities::random_val(0, 1)) / 2.f;
-    p.color.r = (uint8_t)(Utilities::interp_linear(0.15f, 0.2f, r) * 255.f);
-    p.color.g = (uint8_t)(Utilities::interp_linear(0.15f, 0.2f, r) * 255.f);
-    p.color.b = (uint8_t)(Utilities::interp_linear(0.15f, 0.2f, r) * 255.f);
-    p.color.a = 255;
-    return p;
+    return create_particle(mat_id_gunpowder);
 }
 
 Particle ParticleSimulator::particle_oil()
 {
-    Particle p = {0};
-    p.id = mat_id_oil;
-    float r = (float)(Utilities::random_val(0, 1)) / 2.f;
-    p.color.r = (uint8_t)(Utilities::interp_linear(0.12f, 0.15f, r) * 255.f);
-    p.color.g = (uint8_t)(Utilities::interp_linear(0.10f, 0.12f, r) * 255.f);
-    p.color.b = (uint8_t)(Utilities::interp_linear(0.08f, 0.10f, r) * 255.f);
-    p.color.a = 255;
-    return p;
+    return create_particle(mat_id_oil);
 }
 
 Particle ParticleSimulator::particle_stone()
 {
-    Particle p = {0};
-    p.id = mat_id_stone;
-    float r = (float)(Utilities::random_val(0, 1)) / 2.f;
-    p.color.r = (uint8_t)(Utilities::interp_linear(0.5f, 0.65f, r) * 255.f);
-    p.color.g = (uint8_t)(Utilities::interp_linear(0.5f, 0.65f, r) * 255.f);
-    p.color.b = (uint8_t)(Utilities::interp_linear(0.5f, 0.65f, r) * 255.f);
-    p.color.a = 255;
-    return p;
+    return create_particle(mat_id_stone);
 }
 
 Particle ParticleSimulator::particle_acid()
 {
-    Particle p = {0};
-    p.id = mat_id_acid;
-    float r = (float)(Utilities::random_val(0, 1)) / 2.f;
-    p.color.r = (uint8_t)(Utilities::interp_linear(0.05f, 0.06f, r) * 255.f);
-    p.color.g = (uint8_t)(Utilities::interp_linear(0.8f, 0.85f, r) * 255.f);
-    p.color.b = (uint8_t)(Utilities::interp_linear(0.1f, 0.12f, r) * 255.f);
-    p.color.a = 200;
-    return p;
+    return create_particle(mat_id_acid);
 }
 
 void ParticleSimulator::update_particle_sim()
 {
+    for (int32_t id = 0; id < 256; ++id) {
+        m_accel_table[id] = m_gravity_sign_table[id] * m_gravity * m_deltaTime;
+    }
+
+    // 取出上一帧累计的脏矩形，清除其中的更新标记并积分重力。
+    // 上一帧写入过的格子都在新的脏矩形内，每个区块只写自己的格子，可以一次全部并行
+    uint32_t chunk_count = (uint32_t)(m_chunkCountX * m_chunkCountY);
+    m_thread_pool->parallel_for(chunk_count, [this](uint32_t chunk) {
+        release_chunk_claims(chunk % m_chunkCountX, chunk / m_chunkCountX);
+        m_chunks[chunk].swap_rect();
+        if (m_chunks[chunk].is_awake(m_chunk_sleep_frames)) {
+            clear_chunk_flags(chunk % m_chunkCountX, chunk / m_chunkCountX);
+            integrate_chunk(chunk % m_chunkCountX, chunk / m_chunkCountX);
+        }
+    });
+
+    if (m_engine == SIM_ENGINE_MARGOLUS) {
+        // 块互不重叠，所有区块一次并行
+        int32_t offset = (int32_t)(m_frame & 1);
+        m_thread_pool->parallel_for(chunk_count, [this, offset](uint32_t chunk) {
+            Utilities::seed_random(random_key(m_world_seed, m_frame, chunk));
+            update_chunk_margolus(chunk % m_chunkCountX, chunk / m_chunkCountX, offset);
+        });
+        // 块规则只移动格子，寿命在所有块移动完之后流逝；每个区块只写自己的格子
+        m_thread_pool->parallel_for(chunk_count, [this](uint32_t chunk) {
+            decay_chunk(chunk % m_chunkCountX, chunk / m_chunkCountX);
+        });
+    } else if (m_engine == SIM_ENGINE_INTENT) {
+        // 第一遍只读网格并认领格子，第二遍执行拿到认领的意图，两遍之间只有 parallel_for 的同步
+        if (!m_move_claims) m_move_claims = new std::atomic<uint64_t>[m_grid.id.size()]();
+        m_thread_pool->parallel_for(chunk_count, [this](uint32_t chunk) {
+            Utilities::seed_random(random_key(m_world_seed, m_frame, chunk));
+            emit_chunk_intents(chunk % m_chunkCountX, chunk / m_chunkCountX);
+        });
+        m_thread_pool->parallel_for(chunk_count, [this](uint32_t chunk) {
+            apply_chunk_intents(chunk % m_chunkCountX, chunk / m_chunkCountX);
+        });
+        m_thread_pool->parallel_for(chunk_count, [this](uint32_t chunk) {
+            decay_chunk(chunk % m_chunkCountX, chunk / m_chunkCountX);
+        });
+    } else {
+        // 液体在搜索范围之外的落点方向按整行求出，只计算有唤醒区块的区块行；各行只写自己的位，可以并行
+        m_thread_pool->parallel_for((uint32_t)m_chunkCountY, [this](uint32_t cy) {
+            bool awake = false;
+            for (int32_t cx = 0; cx < m_chunkCountX && !awake; ++cx) {
+                awake = m_chunks[cy * m_chunkCountX + cx].is_awake(m_chunk_sleep_frames);
+            }
+            if (!awake) return;
+            int32_t y1 = std::min((int32_t)(cy + 1) * SIM_CHUNK_SIZE, m_textureHeight);
+            for (int32_t y = (int32_t)cy * SIM_CHUNK_SIZE; y < y1; ++y) m_occupancy.update_drain_row(y);
+        });
+
+        // 4 个棋盘格阶段依次执行，阶段内的区块并行更新，休眠的区块直接跳过
+        std::vector<uint32_t> awake_chunks;
+        for (int32_t phase = 0; phase < SIM_PHASE_COUNT; ++phase) {
+            awake_chunks.clear();
+            for (uint32_t chunk : m_phase_chunks[phase]) {
+                if (m_chunks[chunk].is_awake(m_chunk_sleep_frames)) awake_chunks.push_back(chunk);
+            }
+            m_thread_pool->parallel_for((uint32_t)awake_chunks.size(), [this, &awake_chunks](uint32_t i) {
+                uint32_t chunk = awake_chunks[i];
+                update_chunk(chunk % m_chunkCountX, chunk / m_chunkCountX);
+            });
+        }
+    }
+
+    ++m_frame;
+    // 调用线程刚才执行的区块改写了它的随机流，为帧间的笔刷等操作重新设定
+    Utilities::seed_random(random_key(m_world_seed, m_frame, UINT64_MAX));
+}
+
+void ParticleSimulator::clear_chunk_flags(int32_t cx, int32_t cy)
+{
+    const SimChunk& c = m_chunks[cy * m_chunkCountX + cx];
+    if (c.min_x > c.max_x) return;
+    const SimKernels& kernels = simd_kernels();
+    for (int32_t y = c.min_y; y <= c.max_y; ++y) {
+        kernels.clear_bytes(&m_grid.updated[compute_idx(c.min_x, y)], c.max_x - c.min_x + 1);
+    }
+}
+
+void ParticleSimulator::integrate_chunk(int32_t cx, int32_t cy)
+{
+    // 在任何粒子移动之前积分，每个粒子每帧恰好积分一次，移动函数只做位移。
+    // 跨区块移动的粒子已在出发的区块积分过，不会重复
+    const SimChunk& c = m_chunks[cy * m_chunkCountX + cx];
+    if (c.min_x > c.max_x) return;
+    const SimKernels& kernels = simd_kernels();
+    for (int32_t y = c.min_y; y <= c.max_y; ++y) {
+        int32_t idx = compute_idx(c.min_x, y);
+        kernels.integrate_gravity(&m_grid.id[idx], &m_grid.velocity[idx], m_accel_table, m_max_speed_table,
+                                  c.max_x - c.min_x + 1);
+    }
+}
+
+void ParticleSimulator::update_chunk(int32_t cx, int32_t cy)
+{
+    // 随机序列只由帧号和区块位置决定，与哪个线程执行无关
+    uint32_t chunk = (uint32_t)(cy * m_chunkCountX + cx);
+    Utilities::seed_random(random_key(m_world_seed, m_frame, chunk));
+    if (m_bitboard_powder && update_chunk_bitboard(cx, cy)) return;
+
+    // 只扫描脏矩形内的格子
+    const SimChunk& c = m_chunks[chunk];
+    int32_t x0 = c.min_x;
+    int32_t x1 = c.max_x + 1;
+    int32_t y0 = c.min_y;
+    int32_t y1 = c.max_y + 1;
+
+    // 自下而上扫描，水平方向每帧交替，减少方向偏差
+    bool left_to_right = (m_frame & 1) == 0;
+    for (int32_t y = y1 - 1; y >= y0; --y) {
+        for (int32_t i = 0; i < x1 - x0; ++i) {
+            int32_t x = left_to_right ? x0 + i : x1 - 1 - i;
+            // 下方是空格、上方是同一材质时才可能是下落段的段头
+            int32_t idx = compute_idx(x, y);
+            uint8_t id = m_grid.id[idx];
+            if (m_column_run_table[id] && m_grid.id[idx + m_neighbor_offset[NEIGHBOR_DOWN]] == mat_id_empty &&
+                m_grid.id[idx + m_neighbor_offset[NEIGHBOR_UP]] == id &&
+                update_column_run(x, y)) {
+                continue;
+            }
+            update_cell((uint32_t)x, (uint32_t)y);
+        }
+    }
+}
+
+void ParticleSimulator::update_chunk_margolus(int32_t cx, int32_t cy, int32_t offset)
+{
+    // 块归左上角所在的区块所有；奇数 tick 世界左、上边缘的块从 -1 开始，归第 0 列、第 0 行的区块
+    int32_t own_x0 = cx * SIM_CHUNK_SIZE - (cx == 0 ? offset : 0);
+    int32_t own_y0 = cy * SIM_CHUNK_SIZE - (cy == 0 ? offset : 0);
+    int32_t own_x1 = std::min((cx + 1) * SIM_CHUNK_SIZE, m_textureWidth) - 1;
+    int32_t own_y1 = std::min((cy + 1) * SIM_CHUNK_SIZE, m_textureHeight) - 1;
+
+    // 处理与醒着的脏矩形相交的块。块向右、向下各伸出一格，右、下、右下区块的脏矩形也要考虑
+    SimBounds area;
+    for (int32_t dy = 0; dy < 2; ++dy) {
+        for (int32_t dx = 0; dx < 2; ++dx) {
+            if (cx + dx >= m_chunkCountX || cy + dy >= m_chunkCountY) continue;
+            const SimChunk& n = m_chunks[(cy + dy) * m_chunkCountX + cx + dx];
+            if (!n.is_awake(m_chunk_sleep_frames) || n.min_x > n.max_x || n.min_y > n.max_y) continue;
+            area.add(n.min_x - 1, n.min_y - 1, n.max_x, n.max_y);
+        }
+    }
+    int32_t x0 = std::max(area.min_x, own_x0);
+    int32_t y0 = std::max(area.min_y, own_y0);
+    int32_t x1 = std::min(area.max_x, own_x1);
+    int32_t y1 = std::min(area.max_y, own_y1);
+    if (area.empty() || x0 > x1 || y0 > y1) return;
+
+    // 块的左上角与 offset 同奇偶
+    x0 += (x0 - offset) & 1;
+    y0 += (y0 - offset) & 1;
+
+    const MargolusRules& rules = margolus_rules();
+    const int32_t offsets[4] = { 0, m_neighbor_offset[NEIGHBOR_RIGHT], m_neighbor_offset[NEIGHBOR_DOWN],
+                                 m_neighbor_offset[NEIGHBOR_DOWN_RIGHT] };
+    bool moved = false;
+    uint64_t random = 0;
+    int32_t random_left = 0;
+    for (int32_t by = y0; by <= y1; by += 2) {
+        for (int32_t bx = x0; bx <= x1; bx += 2) {
+            // 四格相同的块（空地、堆积内部）任何规则下都不变
+            int32_t idx = compute_idx(bx, by);
+            const uint8_t* ids = &m_grid.id[idx];
+            if (ids[0] == ids[offsets[1]] && ids[0] == ids[offsets[2]] && ids[0] == ids[offsets[3]]) continue;
+
+            if (random_left == 0) {
+                random = Utilities::random_bits64();
+                random_left = 32;
+            }
+            uint32_t variant = (uint32_t)(random & 3);
+            random >>= 2;
+            --random_left;
+
+            uint8_t perm = rules.perm[variant][margolus_index(m_margolus_class[ids[offsets[0]]], m_margolus_class[ids[offsets[1]]],
+                                                              m_margolus_class[ids[offsets[2]]], m_margolus_class[ids[offsets[3]]])];
+            if (perm == MARGOLUS_IDENTITY) continue;
+
+            Particle cells[4];
+            for (int32_t i = 0; i < 4; ++i) cells[i] = m_grid.get(idx + offsets[i]);
+            for (int32_t i = 0; i < 4; ++i) {
+                int32_t from = (perm >> (2 * i)) & 3;
+                if (from != i) write_data(idx + offsets[i], cells[from]);
+            }
+            moved = true;
+        }
+    }
+
+    // 某些组合只在另一种划分下才能移动：有块变化之后，处理过的范围在接下来两个 tick 内保持醒着
+    SimChunk& c = m_chunks[cy * m_chunkCountX + cx];
+    if (moved || c.block_moved) {
+        c.expand_next(std::max(x0, cx * SIM_CHUNK_SIZE), std::max(y0, cy * SIM_CHUNK_SIZE), x1, y1);
+    }
+    c.block_moved = moved;
+}
+
+void ParticleSimulator::decay_chunk(int32_t cx, int32_t cy)
+{
+    // 与 update_movement 中的寿命规则相同。寿命还在流逝的粒子每个 tick 都标记脏矩形，
+    // 块引擎每个 tick 最多移动一格，移动后的粒子仍在本区块的脏矩形内，每个粒子每个 tick 恰好处理一次
+    const SimChunk& c = m_chunks[cy * m_chunkCountX + cx];
+    if (!c.is_awake(m_chunk_sleep_frames) || c.min_x > c.max_x) return;
+
+    for (int32_t y = c.min_y; y <= c.max_y; ++y) {
+        for (int32_t x = c.min_x; x <= c.max_x; ++x) {
+            int32_t idx = compute_idx(x, y);
+            float& lifetime = m_grid.lifetime[idx];
+            if (!m_decay_table[m_grid.id[idx]] || lifetime <= 0.f) continue;
+            lifetime -= m_deltaTime;
+            if (lifetime <= 0.f) write_data(idx, particle_empty());
+            else mark_dirty(x, y);
+        }
+    }
+}
+
+bool ParticleSimulator::update_column_run(int32_t x, int32_t y)
+{
+    // (x, y) 是一段同材质、同位移的竖直连续段的最下端（扫描自下而上，先遇到它）。
+    // 段下方的落点全是空格时，逐格执行 update_movement 的结果就是整段下移 fall 格，
+    // 这里按平面逐格搬运，只维护两端变化的占用位和脏矩形；落点不空时段头交给 update_cell
+    int32_t idx = compute_idx(x, y);
+    uint8_t id = m_grid.id[idx];
+    // 调用者已确认材质可以整段下落、下方是空格、上方同材质
+    if (m_grid.updated[idx]) return false;
+
+    uint8_t frac = m_grid.frac_y[idx];
+    int32_t fall = fixed_fall(fixed_from_float(std::fabs(m_grid.velocity[idx].y)), frac);
+    if (trace_path(idx, 0, fall, k_mask_empty) != idx + fall * m_stride) return false;
+
+    // 向上延伸到材质、位移不同的格子为止；本帧只更新脏矩形内、区块内的格子
+    const SimChunk& c = m_chunks[(y / SIM_CHUNK_SIZE) * m_chunkCountX + x / SIM_CHUNK_SIZE];
+    int32_t top = y;
+    while (top - 1 >= c.min_y) {
+        int32_t above = idx - (y - top + 1) * m_stride;
+        if (m_grid.id[above] != id || m_grid.updated[above]) break;
+        frac = m_grid.frac_y[above];
+        if (fixed_fall(fixed_from_float(std::fabs(m_grid.velocity[above].y)), frac) != fall) break;
+        --top;
+    }
+    if (y - top + 1 < SIM_MIN_COLUMN_RUN) return false;
+
+    // 自下而上搬运，目标都在源的下方，不会覆盖还没搬的格子；各格的亚格余量按自己的速度累积
+    for (int32_t row = y; row >= top; --row) {
+        int32_t src = compute_idx(x, row);
+        int32_t dst = src + fall * m_stride;
+        m_grid.id[dst] = m_grid.id[src];
+        m_grid.lifetime[dst] = m_grid.lifetime[src];
+        m_grid.velocity[dst] = m_grid.velocity[src];
+        m_grid.variation[dst] = m_grid.variation[src];
+        m_grid.frac_x[dst] = m_grid.frac_x[src];
+        m_grid.frac_y[dst] = m_grid.frac_y[src];
+        fixed_fall(fixed_from_float(std::fabs(m_grid.velocity[dst].y)), m_grid.frac_y[dst]);
+        m_grid.updated[dst] = 1;
+    }
+    // 段顶空出的 fall 格（段比 fall 短时整段都空出）换成原来落点处的空格
+    int32_t vacated = std::min(y, top + fall - 1);
+    for (int32_t row = top; row <= vacated; ++row) {
+        m_grid.set(compute_idx(x, row), Particle { mat_id_empty, 0.f, Vec2 { 0.f, 0.f }, true, 0, 0, 0 });
+        m_occupancy.set(x, row, false, false, false);
+    }
+    uint8_t phase = m_phase_table[id];
+    for (int32_t row = std::max(y + 1, top + fall); row <= y + fall; ++row) {
+        m_occupancy.set(x, row, true, phase == PHASE_LIQUID, phase == PHASE_GAS);
+    }
+
+    // 段跨越的范围：两端和原段头，段头在区块底边时顺带唤醒下方区块
+    mark_dirty(x, top);
+    mark_dirty(x, y);
+    mark_dirty(x, y + fall);
+    return true;
+}
+
+void ParticleSimulator::update_cell(uint32_t x, uint32_t y)
+{
+    int32_t idx = compute_idx(x, y);
+    if (m_grid.updated[idx]) return;
+
+    UpdateFn fn = m_update_table[m_grid.id[idx]];
+    if (fn) (this->*fn)(x, y);
 }
 
 void ParticleSimulator::update_sand(uint32_t x, uint32_t y)
 {
-	// For water, same as sand, but we'll check immediate left and right as well
-	uint32_t read_idx = compute_idx(x, y);
-	Particle* p = &((*m_particles)[read_idx]);
-
-    //更新速度
-	p->velocity.y = utilities_clamp(p->velocity.y + (m_gravity * m_deltaTime), -10.f, 10.f);
-
-	// 检查粒子是否可以直接下落，如果粒子下方是边界内且非空且不是水，则将速度减半
-	if (in_bounds(x, y + 1) && !is_empty(x, y + 1) && get_particle_at(x, y + 1).id != mat_id_water) {
-		p->velocity.y /= 2.f;
-	}
-
-    // 计算新的位置
-	int32_t vi_x = x + (int32_t)p->velocity.x; 
-	int32_t vi_y = y + (int32_t)p->velocity.y;
-
-	uint32_t b_idx = compute_idx(x, y + 1);
-	uint32_t br_idx = compute_idx(x + 1, y + 1);
-	uint32_t bl_idx = compute_idx(x - 1, y + 1);
-
-	int32_t lx, ly;
-
-	Particle tmp_a = (*m_particles)[read_idx]; // 读取当前粒子
-    
-
-	// 检查是否可以交换位置Physics (using velocity)
-	if (in_bounds(vi_x, vi_y) && (is_empty(vi_x, vi_y) ||
-			((get_particle_at(vi_x, vi_y).id == mat_id_water) && 
-			  !get_particle_at(vi_x, vi_y).updated && 
-			   math_vec2_len(get_particle_at(vi_x, vi_y).velocity) - math_vec2_len(tmp_a.velocity) > 10.f))) {
-
-		Particle tmp_b = get_particle_at(vi_x, vi_y); // 读取目标位置上的粒子
-
-		// Try to throw water out
-		if (tmp_b.id == mat_id_water) {
-
-			int32_t rx = Utilities::random_val(-2, 2);
-			tmp_b.velocity = (Vec2){(float)rx, -4.f};
-
-			write_data(compute_idx(vi_x, vi_y), tmp_a);	
-
-			for(int32_t i = -10; i < 0; ++i) {
-				for (int32_t j = -10; j < 10; ++j) {
-					if (is_empty(vi_x + j, vi_y + i)) {
-						write_data(compute_idx(vi_x + j, vi_y + i), tmp_b);
-						break;
-					}	
-				}
-			}
-
-			// Couldn't write there, so, uh, destroy it.
-			write_data(read_idx, particle_empty());
-		}
-		else if (is_empty(vi_x, vi_y)) {
-			write_data(compute_idx(vi_x, vi_y), tmp_a);
-			write_data(read_idx, tmp_b);
-		}
-	}
-	//Simple falling, changing the velocity here ruins everything. I need to redo this entire simulation.
-	// else if (in_bounds(x, y + 1) && ((is_empty(x, y + 1) || ((*m_particles)[b_idx].id == mat_id_water)))) {
-	// 	p->velocity.y += (m_gravity * m_deltaTime);
-	// 	Particle tmp_b = get_particle_at(x, y + 1);
-	// 	write_data(b_idx, *p);
-	// 	write_data(read_idx, tmp_b);
-	// }
-	// else if (in_bounds(x - 1, y + 1) && ((is_empty(x - 1, y + 1) || (*m_particles)[bl_idx].id == mat_id_water))) {
-	// 	p->velocity.x = is_in_liquid(x, y, &lx, &ly) ? 0.f : Utilities::random_val(0, 1) == 0 ? -1.f : 1.f;
-	// 	p->velocity.y += (m_gravity * m_deltaTime);
-	// 	Particle tmp_b = get_particle_at(x - 1, y + 1);
-	// 	write_data(bl_idx, *p);
-	// 	write_data(read_idx, tmp_b);
-	// }
-	// else if (in_bounds(x + 1, y + 1) && ((is_empty(x + 1, y + 1) || (*m_particles)[br_idx].id == mat_id_water))) {
-	// 	p->velocity.x = is_in_liquid(x, y, &lx, &ly) ? 0.f : Utilities::random_val(0, 1) == 0 ? -1.f : 1.f;
-	// 	p->velocity.y += (m_gravity * m_deltaTime);
-	// 	Particle tmp_b = get_particle_at(x + 1, y + 1);
-	// 	write_data(br_idx, *p);
-	// 	write_data(read_idx, tmp_b);
-	// }
-	// else if (is_in_liquid(x, y, &lx, &ly) && Utilities::random_val(0, 10) == 0) {
-	// 	Particle tmp_b = get_particle_at(lx, ly);
-	// 	write_data(compute_idx(lx, ly), *p);
-	// 	write_data(read_idx, tmp_b);
-	// }
+    update_movement<ARCHETYPE_POWDER, SandTraits>(x, y);
 }
 
 void ParticleSimulator::update_water(uint32_t x, uint32_t y)
 {
+    update_movement<ARCHETYPE_LIQUID, WaterTraits>(x, y);
 }
 
 void ParticleSimulator::update_salt(uint32_t x, uint32_t y)
 {
+    update_movement<ARCHETYPE_POWDER, SaltTraits>(x, y);
 }
 
 void ParticleSimulator::update_fire(uint32_t x, uint32_t y)
 {
+    update_movement<ARCHETYPE_GAS, FireTraits>(x, y);
 }
 
 void ParticleSimulator::update_lava(uint32_t x, uint32_t y)
 {
+    update_movement<ARCHETYPE_LIQUID, LavaTraits>(x, y);
 }
 
 void ParticleSimulator::update_smoke(uint32_t x, uint32_t y)
 {
+    update_movement<ARCHETYPE_GAS, SmokeTraits>(x, y);
 }
 
 void ParticleSimulator::update_ember(uint32_t x, uint32_t y)
 {
+    update_movement<ARCHETYPE_POWDER, EmberTraits>(x, y);
 }
 
 void ParticleSimulator::update_steam(uint32_t x, uint32_t y)
 {
+    update_movement<ARCHETYPE_GAS, SteamTraits>(x, y);
 }
 
 void ParticleSimulator::update_gunpowder(uint32_t x, uint32_t y)
 {
+    update_movement<ARCHETYPE_POWDER, GunpowderTraits>(x, y);
 }
 
 void ParticleSimulator::update_oil(uint32_t x, uint32_t y)
 {
+    update_movement<ARCHETYPE_LIQUID, OilTraits>(x, y);
 }
 
 void ParticleSimulator::update_acid(uint32_t x, uint32_t y)
 {
+    update_movement<ARCHETYPE_LIQUID, AcidTraits>(x, y);
 }
 
 void ParticleSimulator::update_default(uint32_t x, uint32_t y)
@@ -1,13 +1,17 @@
 #pragma once
 // main.cpp
-#include <SDL3/SDL.h>
 #include <stdint.h>
 #include <vector>
 #include <cstdlib>
 #include <ctime>
 #include <algorithm>
+#include <atomic>
+#include <string>
 
 #include "Math.h"
+#include "sim/thread_pool.h"
+#include "sim/packed_cell.h"
+#include "sim/occupancy.h"
 
 // 粒子类型定义
 enum MaterialType {
@@ -27,16 +31,106 @@ enum MaterialType {
     MAT_ACID
 };
 
+// 材质的物理形态
+enum MaterialPhase : uint8_t {
+    PHASE_EMPTY = 0,
+    PHASE_SOLID,
+    PHASE_POWDER,
+    PHASE_LIQUID,
+    PHASE_GAS
+};
+
+// 运动原型，决定材质使用哪一类移动规则
+enum MovementArchetype {
+    ARCHETYPE_STATIC = 0,
+    ARCHETYPE_POWDER,
+    ARCHETYPE_LIQUID,
+    ARCHETYPE_GAS
+};
+
 struct Color {
     uint8_t r, g, b, a;
 };
 
+// 调色板模式下每个格子输出的 2 字节：材质 id 和颜色档，颜色由着色器查调色板得到
+struct PaletteCell {
+    uint8_t id;
+    uint8_t variation;
+};
+
+// 模拟器输出给渲染器的格式
+enum SimOutput : uint8_t {
+    SIM_OUTPUT_COLOR = 0,   // colors()：每格 4 字节 RGBA
+    SIM_OUTPUT_PALETTE      // palette_cells()：每格 2 字节，不生成颜色
+};
+
+// 移动规则的执行方式
+enum SimEngine : uint8_t {
+    SIM_ENGINE_CELLULAR = 0,    // 逐格原地移动，按棋盘格阶段和扫描顺序更新，支持全部材质行为
+    SIM_ENGINE_MARGOLUS,        // 2x2 块查表（sim/margolus.h），运动之后另有一遍寿命流逝，适合纯粉末、液体场景
+    SIM_ENGINE_INTENT,          // 先收集移动意图再统一裁决（sim/move_intent.h），运动之后另有一遍寿命流逝，结果与扫描顺序无关
+    SIM_ENGINE_COUNT
+};
+
 struct Particle {
     uint8_t id;
     float lifetime;
     Vec2 velocity;
-    Color color;
     bool updated;
+    uint8_t variation; // 颜色渐变档，颜色由材质表和它决定，在 refresh_output 中生成
+    uint8_t frac_x;    // 亚格位移余量（1/256 格），随粒子移动，见 fixed_advance
+    uint8_t frac_y;
+};
+
+// 粒子数据按属性分平面存储（SoA）。
+// 热点上的邻居检查只读取 id 平面，每个格子只访问 1 字节；
+// 需要完整粒子时用 get/set 在各平面之间聚合/分散。
+struct ParticleGrid {
+    std::vector<uint8_t> id;
+    std::vector<float> lifetime;
+    std::vector<Vec2> velocity;
+    std::vector<uint8_t> updated;
+    std::vector<uint8_t> variation;
+    std::vector<uint8_t> frac_x;
+    std::vector<uint8_t> frac_y;
+
+    void resize(size_t count)
+    {
+        id.assign(count, 0);
+        lifetime.assign(count, 0.f);
+        velocity.assign(count, Vec2{0.f, 0.f});
+        updated.assign(count, 0);
+        variation.assign(count, 0);
+        frac_x.assign(count, 0);
+        frac_y.assign(count, 0);
+    }
+
+    void clear()
+    {
+        std::fill(id.begin(), id.end(), (uint8_t)0);
+        std::fill(lifetime.begin(), lifetime.end(), 0.f);
+        std::fill(velocity.begin(), velocity.end(), Vec2{0.f, 0.f});
+        std::fill(updated.begin(), updated.end(), (uint8_t)0);
+        std::fill(variation.begin(), variation.end(), (uint8_t)0);
+        std::fill(frac_x.begin(), frac_x.end(), (uint8_t)0);
+        std::fill(frac_y.begin(), frac_y.end(), (uint8_t)0);
+    }
+
+    Particle get(int32_t idx) const
+    {
+        return Particle{id[idx], lifetime[idx], velocity[idx], updated[idx] != 0, variation[idx], frac_x[idx], frac_y[idx]};
+    }
+
+    void set(int32_t idx, const Particle& p)
+    {
+        id[idx] = p.id;
+        lifetime[idx] = p.lifetime;
+        velocity[idx] = p.velocity;
+        updated[idx] = p.updated ? 1 : 0;
+        variation[idx] = p.variation;
+        frac_x[idx] = p.frac_x;
+        frac_y[idx] = p.frac_y;
+    }
 };
 
 
@@ -55,6 +149,7 @@ struct Particle {
 #define mat_id_lava (uint8_t)11
 #define mat_id_stone (uint8_t)12
 #define mat_id_acid (uint8_t)13
+#define mat_id_ghost (uint8_t)255 // 网格边框的幽灵格，永远是不可置换的固体
 
 // Colors
 #define mat_col_empty (Color){0, 0, 0, 0}
@@ -72,44 +167,281 @@ struct Particle {
 #define mat_col_lava  (Color){200, 50, 0, 255}
 #define mat_col_acid  (Color){90, 200, 60, 255}
 
+// 模拟按 SIM_CHUNK_SIZE x SIM_CHUNK_SIZE 的区块划分，并按 2x2 棋盘格分 4 个阶段并行更新。
+// 同一阶段的区块之间至少隔开一个区块，因此只要每个粒子的读写范围不超过
+// SIM_MAX_REACH（半个区块），同一阶段内的区块就不会访问到同一个格子。
+#define SIM_CHUNK_SIZE 64
+#define SIM_MAX_REACH (SIM_CHUNK_SIZE / 2)
+#define SIM_PHASE_COUNT 4
+
+// 网格四周各留 SIM_GRID_PADDING 圈幽灵格。内核的读写范围不超过 SIM_MAX_REACH，
+// 因此邻居访问永远落在分配的内存内，不需要边界判断。
+#define SIM_GRID_PADDING SIM_MAX_REACH
+
+// 自由下落的竖直连续段至少这么长才整段平移，更短的逐格更新
+#define SIM_MIN_COLUMN_RUN 4
+
+// 邻居方向，对应 m_neighbor_offset 中的下标差
+enum NeighborDir {
+    NEIGHBOR_UP = 0,
+    NEIGHBOR_DOWN,
+    NEIGHBOR_LEFT,
+    NEIGHBOR_RIGHT,
+    NEIGHBOR_UP_LEFT,
+    NEIGHBOR_UP_RIGHT,
+    NEIGHBOR_DOWN_LEFT,
+    NEIGHBOR_DOWN_RIGHT,
+    NEIGHBOR_COUNT
+};
+
+// 世界坐标下的闭区间矩形
+struct SimRect {
+    int32_t x0, y0, x1, y1;
+};
+
+// 闭区间范围的累积，空时 min > max
+struct SimBounds {
+    int32_t min_x = INT32_MAX, min_y = INT32_MAX;
+    int32_t max_x = INT32_MIN, max_y = INT32_MIN;
+
+    bool empty() const { return min_x > max_x || min_y > max_y; }
+
+    // 并入一个矩形，空矩形不产生影响
+    void add(int32_t x0, int32_t y0, int32_t x1, int32_t y1)
+    {
+        min_x = std::min(min_x, x0);
+        min_y = std::min(min_y, y0);
+        max_x = std::max(max_x, x1);
+        max_y = std::max(max_y, y1);
+    }
+
+    void clear() { *this = SimBounds{}; }
+};
+
+// 按 id 索引的材质集合，覆盖全部 256 个 id
+struct MaterialMask {
+    uint64_t words[4] = {};
+
+    constexpr bool test(uint8_t id) const { return (words[id >> 6] >> (id & 63)) & 1u; }
+    constexpr void set(uint8_t id) { words[id >> 6] |= 1ull << (id & 63); }
+    constexpr bool operator==(const MaterialMask&) const = default;
+};
+
+// 意图引擎中一个格子想与 to 交换位置；key 高 32 位是随机优先级，低 32 位是 from，保证各不相同
+struct MoveIntent {
+    int32_t from;
+    int32_t to;
+    uint64_t key;
+};
+
+// 区块的脏矩形（闭区间，min > max 表示空）。
+// next_* 在更新过程中由 write_data 扩展，可能有相邻区块的线程同时写入，因此使用原子量；
+// 每帧开始时 next_* 被交换到 rect 中作为本帧的更新范围。
+struct SimChunk {
+    int32_t min_x = 1, min_y = 1, max_x = 0, max_y = 0;
+    std::atomic<int32_t> next_min_x { INT32_MAX }, next_min_y { INT32_MAX };
+    std::atomic<int32_t> next_max_x { INT32_MIN }, next_max_y { INT32_MIN };
+    uint32_t idle_frames = UINT32_MAX;
+    bool block_moved = false;   // Margolus 模式下上一个 tick 是否有块发生变化
+    std::vector<MoveIntent> intents;    // 意图引擎中本区块发出的意图，下一个 tick 开始时清除认领
+
+    // 以下两个范围只在 tick 之间或 swap_rect 中访问
+    SimBounds changed;  // 上次 take_changed_regions 之后输出可能变过的范围
+    SimBounds stale;    // 上次 refresh_output 之后输出还没有重新生成的范围
+
+    bool is_awake(uint32_t sleep_frames) const { return idle_frames < sleep_frames; }
+
+    void expand_next(int32_t x0, int32_t y0, int32_t x1, int32_t y1)
+    {
+        atomic_min(next_min_x, x0);
+        atomic_min(next_min_y, y0);
+        atomic_max(next_max_x, x1);
+        atomic_max(next_max_y, y1);
+    }
+
+    // 取出下一帧的脏矩形；为空时沿用上一次的矩形并累计空闲帧数
+    void swap_rect()
+    {
+        int32_t x0 = next_min_x.exchange(INT32_MAX, std::memory_order_relaxed);
+        int32_t y0 = next_min_y.exchange(INT32_MAX, std::memory_order_relaxed);
+        int32_t x1 = next_max_x.exchange(INT32_MIN, std::memory_order_relaxed);
+        int32_t y1 = next_max_y.exchange(INT32_MIN, std::memory_order_relaxed);
+        if (x0 <= x1 && y0 <= y1) {
+            min_x = x0; min_y = y0; max_x = x1; max_y = y1;
+            idle_frames = 0;
+            changed.add(x0, y0, x1, y1);
+            stale.add(x0, y0, x1, y1);
+        } else if (idle_frames != UINT32_MAX) {
+            ++idle_frames;
+        }
+    }
+
+    // 还没被 swap_rect 取走的写入（最后一个 tick 和笔刷）并入 bounds
+    void add_pending(SimBounds& bounds) const
+    {
+        bounds.add(next_min_x.load(std::memory_order_relaxed), next_min_y.load(std::memory_order_relaxed),
+                   next_max_x.load(std::memory_order_relaxed), next_max_y.load(std::memory_order_relaxed));
+    }
+
+    void reset()
+    {
+        min_x = 1; min_y = 1; max_x = 0; max_y = 0;
+        next_min_x = INT32_MAX; next_min_y = INT32_MAX;
+        next_max_x = INT32_MIN; next_max_y = INT32_MIN;
+        idle_frames = UINT32_MAX;
+        block_moved = false;
+        changed.clear();
+        stale.clear();
+    }
+
+    static void atomic_min(std::atomic<int32_t>& a, int32_t v)
+    {
+        int32_t cur = a.load(std::memory_order_relaxed);
+        while (v < cur && !a.compare_exchange_weak(cur, v, std::memory_order_relaxed)) {}
+    }
+
+    static void atomic_max(std::atomic<int32_t>& a, int32_t v)
+    {
+        int32_t cur = a.load(std::memory_order_relaxed);
+        while (v > cur && !a.compare_exchange_weak(cur, v, std::memory_order_relaxed)) {}
+    }
+};
+
+class MaterialRegistry;
+
 class ParticleSimulator {
 private:
-    std::vector<Particle>* m_particles = {0};
+    typedef void (ParticleSimulator::*UpdateFn)(uint32_t x, uint32_t y);
+
+    ParticleGrid m_grid;
+    OccupancyBitmap m_occupancy;
     Color* color_buffer = {0};
-    
-    SDL_Window* m_window;
+    PaletteCell* m_palette_cells = nullptr;
+    SimOutput m_output = SIM_OUTPUT_COLOR;
+
     int m_textureWidth, m_textureHeight;
+    int32_t m_stride = 0; // 含边框的行宽
+    int32_t m_neighbor_offset[NEIGHBOR_COUNT] = {};
+
+    float m_deltaTime = 1.f / 60.f; // 当前 tick 的时间步长
+    float m_accumulator = 0.f;      // 尚未模拟的帧时间
+    bool m_all_changed = true;      // 整个输出都需要重新上传（创建、重置、换材质之后）
+    bool m_output_stale = true;     // 整个输出都需要重新生成
+
+    // 区块调度
+    int32_t m_chunkCountX = 0, m_chunkCountY = 0;
+    std::vector<uint32_t> m_phase_chunks[SIM_PHASE_COUNT];
+    SimChunk* m_chunks = nullptr;
+    ThreadPool* m_thread_pool = nullptr;
+    uint64_t m_frame = 0;
+    uint64_t m_world_seed = 0x5EED;
+
+    // 材质表和按 id 索引的更新函数分派表
+    MaterialRegistry* m_materials = nullptr;
+    UpdateFn m_update_table[256] = {};
+    uint8_t m_phase_table[256] = {}; // MaterialPhase，write_data 维护占用位图时使用
+    // 重力积分参数：运动方向（1 向下，-1 向上，0 不受重力）和速度上限，来自各材质更新函数的特征
+    alignas(64) float m_gravity_sign_table[256] = {};
+    alignas(64) float m_max_speed_table[256] = {};
+    alignas(64) float m_accel_table[256] = {};  // 当前 tick 的速度增量，每个 tick 开始时计算
+    bool m_bitboard_table[256] = {};            // 可以走位板快速路径的粉末
+    bool m_column_run_table[256] = {};          // 可以整段下落的粉末和液体
+    bool m_decay_table[256] = {};               // 按 lifetime 消失的材质
+    uint8_t m_margolus_class[256] = {};         // MargolusClass
+    MaterialMask m_displace_table[256];         // 每种材质可以置换（交换进入）的材质
 
-    float m_deltaTime;
+    SimEngine m_engine = SIM_ENGINE_CELLULAR;
+    // 意图引擎中每个格子当前最高的认领 key，0 表示无人认领；第一次使用时分配
+    std::atomic<uint64_t>* m_move_claims = nullptr;
 
-    int32_t compute_idx(int32_t x, int32_t y)
+    // 世界坐标到含边框网格的下标
+    int32_t compute_idx(int32_t x, int32_t y) const
     {
-        return (y * m_textureWidth + x);
+        return (y + SIM_GRID_PADDING) * m_stride + x + SIM_GRID_PADDING;
     }
 
-    int32_t in_bounds(int32_t x, int32_t y)
+    // 坐标可以超出世界最多 SIM_GRID_PADDING 格，落在幽灵格上时不是空格
+    int32_t is_empty(int32_t x, int32_t y)
     {
-        if (x < 0 || x > (m_textureWidth - 1) || y < 0 || y > (m_textureHeight - 1)) return false;
-        return true;
+        return m_grid.id[compute_idx(x, y)] == mat_id_empty;
     }
 
-    int32_t is_empty(int32_t x, int32_t y)
+    uint8_t id_at(int32_t x, int32_t y)
     {
-        return (in_bounds(x, y) && (*m_particles)[compute_idx(x, y)].id == mat_id_empty);
+        return m_grid.id[compute_idx(x, y)];
     }
 
     Particle get_particle_at(int32_t x, int32_t y)
     {
-        return (*m_particles)[compute_idx(x, y)];
+        return m_grid.get(compute_idx(x, y));
     }
 
     void write_data(int32_t idx, Particle p)
     {
         // Write into particle data for id value
-        (*m_particles)[idx] = p;
-        color_buffer[idx] = p.color;
+        // 写入的粒子本帧不再更新，避免同一粒子被移动两次
+        p.updated = true;
+        m_grid.set(idx, p);
+
+        // 颜色不在这里写，refresh_output 按脏矩形统一生成
+        int32_t x = idx % m_stride - SIM_GRID_PADDING;
+        int32_t y = idx / m_stride - SIM_GRID_PADDING;
+        uint8_t phase = m_phase_table[p.id];
+        m_occupancy.set(x, y, p.id != mat_id_empty, phase == PHASE_LIQUID, phase == PHASE_GAS);
+        mark_dirty(x, y);
+    }
+
+    // 把 (x, y) 及其 8 邻域加入下一帧的脏矩形；落在区块边缘时一并唤醒相邻区块
+    void mark_dirty(int32_t x, int32_t y)
+    {
+        int32_t cx = x / SIM_CHUNK_SIZE;
+        int32_t cy = y / SIM_CHUNK_SIZE;
+        int32_t lx = x - cx * SIM_CHUNK_SIZE;
+        int32_t ly = y - cy * SIM_CHUNK_SIZE;
+
+        expand_chunk_dirty(cx, cy, x, y);
+        if (lx == 0) expand_chunk_dirty(cx - 1, cy, x, y);
+        if (lx == SIM_CHUNK_SIZE - 1) expand_chunk_dirty(cx + 1, cy, x, y);
+        if (ly == 0) {
+            expand_chunk_dirty(cx, cy - 1, x, y);
+            if (lx == 0) expand_chunk_dirty(cx - 1, cy - 1, x, y);
+            if (lx == SIM_CHUNK_SIZE - 1) expand_chunk_dirty(cx + 1, cy - 1, x, y);
+        }
+        if (ly == SIM_CHUNK_SIZE - 1) {
+            expand_chunk_dirty(cx, cy + 1, x, y);
+            if (lx == 0) expand_chunk_dirty(cx - 1, cy + 1, x, y);
+            if (lx == SIM_CHUNK_SIZE - 1) expand_chunk_dirty(cx + 1, cy + 1, x, y);
+        }
+    }
+
+    // 把第 y 行的 [x0, x1]（裁剪到世界内）连同上下两行加入下一帧的脏矩形，每个区块内只标记两端
+    void mark_dirty_span(int32_t x0, int32_t x1, int32_t y)
+    {
+        x0 = std::max(x0, 0);
+        x1 = std::min(x1, m_textureWidth - 1);
+        while (x0 <= x1) {
+            int32_t end = std::min(x1, (x0 / SIM_CHUNK_SIZE + 1) * SIM_CHUNK_SIZE - 1);
+            mark_dirty(x0, y);
+            mark_dirty(end, y);
+            x0 = end + 1;
+        }
     }
 
+    void expand_chunk_dirty(int32_t cx, int32_t cy, int32_t x, int32_t y)
+    {
+        if (cx < 0 || cx >= m_chunkCountX || cy < 0 || cy >= m_chunkCountY) return;
+
+        int32_t x0 = cx * SIM_CHUNK_SIZE;
+        int32_t y0 = cy * SIM_CHUNK_SIZE;
+        int32_t x1 = std::min(x0 + SIM_CHUNK_SIZE, m_textureWidth) - 1;
+        int32_t y1 = std::min(y0 + SIM_CHUNK_SIZE, m_textureHeight) - 1;
+
+        m_chunks[cy * m_chunkCountX + cx].expand_next(
+            std::max(x - 1, x0), std::max(y - 1, y0),
+            std::min(x + 1, x1), std::min(y + 1, y1));
+    }
+
+    Particle create_particle(uint8_t id);
     Particle particle_empty();
     Particle particle_sand();
     Particle particle_water();
@@ -126,6 +458,22 @@ private:
     Particle particle_acid();
 
     // Particle updates
+    void build_update_table();
+    void build_ghost_border();
+    void build_chunk_phases();
+    void clear_chunk_flags(int32_t cx, int32_t cy);
+    void integrate_chunk(int32_t cx, int32_t cy);
+    void update_chunk(int32_t cx, int32_t cy);
+    bool update_chunk_bitboard(int32_t cx, int32_t cy);
+    void update_chunk_margolus(int32_t cx, int32_t cy, int32_t offset);
+    void decay_chunk(int32_t cx, int32_t cy);
+    int32_t find_move_target(int32_t idx, uint8_t cls, uint64_t random);
+    void emit_chunk_intents(int32_t cx, int32_t cy);
+    void apply_chunk_intents(int32_t cx, int32_t cy);
+    void release_chunk_claims(int32_t cx, int32_t cy);
+    void bitboard_swap(int32_t idx, int32_t offset);
+    bool update_column_run(int32_t x, int32_t y);
+    void update_cell(uint32_t x, uint32_t y);
     void update_particle_sim();
     void update_sand(uint32_t x, uint32_t y);
     void update_water(uint32_t x, uint32_t y);
@@ -139,6 +487,13 @@ private:
     void update_oil(uint32_t x, uint32_t y);
     void update_acid(uint32_t x, uint32_t y);
     void update_default(uint32_t x, uint32_t y);
+
+    // 运动原型内核，定义见 sim/movement_kernels.h
+    template <MovementArchetype A, typename Traits>
+    void update_movement(uint32_t x, uint32_t y);
+    bool can_displace(uint8_t mover, int32_t idx);
+    int32_t trace_path(int32_t idx, int32_t dx, int32_t dy, const MaterialMask& passable);
+    void move_to(int32_t idx, int32_t target);
     
 public:
     ParticleSimulator();
@@ -149,7 +504,65 @@ public:
 
     void resetParticles();
 
-    void update(float deltaTime);
+    // 按固定步长推进模拟，deltaTime 为真实的帧时间，返回本帧执行的 tick 数
+    uint32_t update(float deltaTime);
+
+    // 执行一个固定 tick（1 / m_tick_rate 秒），不经过累加器
+    void step();
+
+    // 距离累加器攒满下一个 tick 还差的时间（秒）
+    float time_to_next_tick() const { return std::max(0.f, 1.f / m_tick_rate - m_accumulator); }
+
+    int32_t width() const { return m_textureWidth; }
+    int32_t height() const { return m_textureHeight; }
+    uint64_t frame() const { return m_frame; }
+
+    // 当前没有休眠的区块数，整个世界静止后为 0
+    int32_t awake_chunk_count() const;
+
+    // 按 id 和颜色档平面重新生成上次刷新以来变化过的输出，只处理脏矩形。
+    // update() 在执行过 tick 后会自动调用；直接调用 step() 时需要自己调用
+    void refresh_output();
+
+    // 按行存储的 width * height 颜色缓冲区，只在 SIM_OUTPUT_COLOR 下、refresh_output 之后有效
+    const Color* colors() const { return color_buffer; }
+
+    // 按行存储的 width * height 调色板索引，只在 SIM_OUTPUT_PALETTE 下、refresh_output 之后有效
+    const PaletteCell* palette_cells() const { return m_palette_cells; }
+
+    // 切换输出格式，下一次 refresh_output 重新生成整个输出，随后的变化区域为整个世界
+    void set_output(SimOutput output);
+    SimOutput output() const { return m_output; }
+
+    // 切换移动规则的执行方式，从下一个 tick 开始生效
+    void set_engine(SimEngine engine) { m_engine = engine; }
+    SimEngine engine() const { return m_engine; }
+
+    // 取出上次调用以来颜色发生过变化的区域（每个区块至多一个矩形）并清空记录。
+    // 结果是实际变化的超集，渲染器只需上传这些区域即可与 colors() 保持一致
+    void take_changed_regions(std::vector<SimRect>& out);
+
+    // 笔刷：在圆或矩形（闭区间）内放置材质，density 为每个格子被放置的概率，超出世界的部分忽略
+    void paint_circle(int32_t x, int32_t y, int32_t radius, uint8_t id, float density = 1.f);
+    void paint_rect(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint8_t id, float density = 1.f);
+
+    // 从文本文件加载材质定义并重建分派表，失败时保留当前定义
+    bool load_materials(const std::string& path);
+    const MaterialRegistry& materials() const { return *m_materials; }
+    const OccupancyBitmap& occupancy() const { return m_occupancy; }
+
+    // 以 8 字节紧凑编码导出/导入整个世界，颜色在导入时由材质表重建。
+    // 标志位描述导出时的状态，导入时忽略：写入的格子本来就标记为已更新，是否下落由邻居决定
+    void export_packed(std::vector<PackedCell>& cells) const;
+    void import_packed(const std::vector<PackedCell>& cells);
+
+    // 设置世界种子并把帧号归零，相同的种子和输入产生逐位相同的结果
+    void set_seed(uint64_t seed);
+    uint64_t seed() const { return m_world_seed; }
+
+    // 设置模拟使用的线程数（包含调用线程），0 表示使用全部硬件线程
+    void set_thread_count(uint32_t count);
+    uint32_t thread_count() const { return m_thread_pool ? m_thread_pool->thread_count() : 1; }
 
     float m_gravity = 10.f; // pixels per second per second
     float m_selection_radius = 10.f;
@@ -157,5 +570,12 @@ public:
     bool m_run_simulation = true;
     bool m_show_frame_count = true;
     bool m_use_post_processing = true;
+    uint32_t m_chunk_sleep_frames = 8; // 脏矩形连续为空多少帧后区块进入休眠
+    bool m_bitboard_powder = true;     // 只有一种粉末和空格的区块按位板整行更新
+
+    float m_tick_rate = 60.f;          // 每秒模拟的 tick 数，物理只依赖 tick 而不依赖帧率
+    uint32_t m_max_substeps = 4;       // 每帧最多执行的 tick 数
+    bool m_turbo = false;              // 快进模式：每帧在 m_turbo_budget_ms 内尽量多跑 tick
+    float m_turbo_budget_ms = 14.f;
 
 };
\ No newline at end of file
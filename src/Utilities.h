@@ -3,6 +3,8 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+#include "sim/random.h"
+
 #define utilities_clamp(V, MIN, MAX) ((V) > (MAX) ? (MAX) : (V) < (MIN) ? (MIN) : (V))
 
 class Utilities
@@ -13,14 +15,31 @@ public:
     Utilities(/* args */);
     ~Utilities();
 
+    // 每个线程独立的随机流，由调度器在更新每个区块前用 (世界种子, 帧号, 区块索引)
+    // 派生的 key 重新设定，保证结果与线程数无关
+    static inline thread_local RandomStream s_random;
+
+    static void seed_random(uint64_t key)
+    {
+        s_random.seed(key);
+    }
+
     static int32_t random_val(int32_t lower, int32_t upper)
     {
-        if (upper < lower) {
-            int32_t tmp = lower;
-            lower = upper;
-            upper = tmp;
-        }
-        return (rand() % (upper - lower + 1) + lower);
+        return s_random.range(lower, upper);
+    }
+
+    // [0, 1) 内的随机浮点数
+    static float random_unit()
+    {
+        return s_random.uniform();
+    }
+
+    // 64 个独立的随机位，位板每个格子取一位
+    static uint64_t random_bits64()
+    {
+        uint64_t hi = s_random.next();
+        return (hi << 32) | s_random.next();
     }
     static inline float interp_linear(float a, float b, float t)
     {
@@ -28,10 +47,10 @@ public:
     }
 };
 
-Utilities::Utilities(/* args */)
+inline Utilities::Utilities(/* args */)
 {
 }
 
-Utilities::~Utilities()
+inline Utilities::~Utilities()
 {
 }
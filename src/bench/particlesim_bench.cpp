@@ -0,0 +1,336 @@
+// particlesim_bench：只链接模拟核心的基准测试。
+// 对每个标准场景、每个世界尺寸和每个线程数，先预热再计时，输出 JSON：
+//
+//   particlesim_bench [--frames N] [--warmup N] [--sizes 256,512,1024] [--threads 1,2,4]
+//                     [--scenes sand_avalanche,...] [--out bench.json] [--simd avx2]
+//                     [--engine cellular|margolus|intent]
+//   particlesim_bench --help
+//
+// 同一场景在不同线程数下的 world_hash 必须一致，否则说明并行更新不确定。
+#include <stdint.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+#include "ParticleSim.h"
+#include "sim/simd.h"
+#include "sim/snapshot.h"
+
+// 场景在预热前构建；step 在每一帧（包括预热帧）开始前调用，用于持续注入粒子
+struct BenchScene {
+    const char* name;
+    void (*build)(ParticleSimulator& sim, int32_t w, int32_t h);
+    void (*step)(ParticleSimulator& sim, int32_t w, int32_t h, uint64_t frame);
+};
+
+struct BenchResult {
+    std::string scene;
+    int32_t width, height;
+    uint32_t threads;
+    double ns_per_cell_step;
+    double steps_per_second;
+    double frame_ms_p50;
+    double frame_ms_max;
+    uint64_t hash;
+};
+
+// 沙崩：上半部分是大块的沙子，下落后在地面堆成斜坡
+static void build_sand_avalanche(ParticleSimulator& sim, int32_t w, int32_t h)
+{
+    sim.paint_rect(0, h - 4, w - 1, h - 1, mat_id_stone);
+    sim.paint_rect(w / 8, 0, w - w / 8, h / 2, mat_id_sand, 0.85f);
+}
+
+// 满水池：石头围成的水池装满水，水面持续扰动
+static void build_water_basin(ParticleSimulator& sim, int32_t w, int32_t h)
+{
+    sim.paint_rect(0, h - 4, w - 1, h - 1, mat_id_stone);
+    sim.paint_rect(0, h / 8, 3, h - 1, mat_id_stone);
+    sim.paint_rect(w - 4, h / 8, w - 1, h - 1, mat_id_stone);
+    sim.paint_rect(4, h / 4, w - 5, h - 5, mat_id_water);
+}
+
+static void step_water_basin(ParticleSimulator& sim, int32_t w, int32_t h, uint64_t frame)
+{
+    (void)h;
+    if (frame % 8 == 0) sim.paint_circle(w / 2, 4, 4, mat_id_water);
+}
+
+// 气体羽流：成排的树木和一层油之间持续注入火焰和烟，测量上升、扩散、按寿命消失的气体。
+// 模拟中没有燃烧，树木和油只是障碍物
+static void build_gas_plumes(ParticleSimulator& sim, int32_t w, int32_t h)
+{
+    sim.paint_rect(0, h - 8, w - 1, h - 1, mat_id_stone);
+    for (int32_t x = 8; x < w - 8; x += 24) {
+        sim.paint_rect(x, h / 2, x + 3, h - 9, mat_id_wood);
+        sim.paint_circle(x + 1, h / 2, 8, mat_id_wood);
+    }
+    sim.paint_rect(0, h - 12, w - 1, h - 9, mat_id_oil);
+}
+
+static void step_gas_plumes(ParticleSimulator& sim, int32_t w, int32_t h, uint64_t frame)
+{
+    (void)frame;
+    for (int32_t x = 16; x < w - 8; x += 48) {
+        sim.paint_circle(x, h - 16, 3, mat_id_fire, 0.5f);
+        sim.paint_circle(x + 24, h / 2 - 10, 2, mat_id_smoke, 0.5f);
+    }
+}
+
+// 混乱：多种材质的色块随机交错
+static void build_mixed_chaos(ParticleSimulator& sim, int32_t w, int32_t h)
+{
+    static const uint8_t ids[] = {
+        mat_id_sand, mat_id_water, mat_id_salt, mat_id_oil, mat_id_acid, mat_id_lava,
+        mat_id_gunpowder, mat_id_smoke, mat_id_steam, mat_id_stone, mat_id_empty
+    };
+    const int32_t block = 16;
+    uint32_t hash = 0x9E3779B9u;
+    for (int32_t y = 0; y < h; y += block) {
+        for (int32_t x = 0; x < w; x += block) {
+            hash = hash * 1664525u + 1013904223u;
+            uint8_t id = ids[(hash >> 16) % (sizeof(ids) / sizeof(ids[0]))];
+            sim.paint_rect(x, y, x + block - 1, y + block - 1, id, 0.8f);
+        }
+    }
+}
+
+static void step_mixed_chaos(ParticleSimulator& sim, int32_t w, int32_t h, uint64_t frame)
+{
+    (void)h;
+    if (frame % 4 == 0) {
+        sim.paint_circle(w / 4, 4, 3, mat_id_sand);
+        sim.paint_circle(3 * w / 4, 4, 3, mat_id_water);
+    }
+}
+
+// 95% 空闲：大部分世界是静止的石头和沙层，只有左侧 5% 宽的竖井里持续有水流过
+static void build_idle_world(ParticleSimulator& sim, int32_t w, int32_t h)
+{
+    int32_t shaft = std::max(4, w / 20);
+    sim.paint_rect(shaft, h / 2, w - 1, h - 1, mat_id_stone);
+    sim.paint_rect(shaft, h / 4, w - 1, h / 2 - 1, mat_id_sand);
+    sim.paint_rect(shaft, 0, shaft, h - 1, mat_id_stone);
+}
+
+static void step_idle_world(ParticleSimulator& sim, int32_t w, int32_t h, uint64_t frame)
+{
+    (void)frame;
+    int32_t shaft = std::max(4, w / 20);
+    sim.paint_rect(0, 0, shaft - 1, 1, mat_id_water);
+    // 竖井底部排水，水流不会停下
+    sim.paint_rect(0, h - 2, shaft - 1, h - 1, mat_id_empty);
+}
+
+static const BenchScene k_scenes[] = {
+    { "sand_avalanche", build_sand_avalanche, nullptr },
+    { "water_basin", build_water_basin, step_water_basin },
+    { "gas_plumes", build_gas_plumes, step_gas_plumes },
+    { "mixed_chaos", build_mixed_chaos, step_mixed_chaos },
+    { "idle_95", build_idle_world, step_idle_world },
+};
+
+struct BenchOptions {
+    uint32_t frames = 200;
+    uint32_t warmup = 50;
+    std::vector<int32_t> sizes = { 256, 512, 1024 };
+    std::vector<uint32_t> threads;
+    std::vector<std::string> scenes;
+    std::string out = "bench.json";
+    SimdLevel simd = SIMD_AVX512;
+    SimEngine engine = SIM_ENGINE_CELLULAR;
+};
+
+static const char* k_usage =
+    "usage: particlesim_bench [--frames N] [--warmup N] [--sizes 256,512,1024] [--threads 1,2,4]\n"
+    "                         [--scenes sand_avalanche,...] [--out bench.json] [--simd avx2]\n"
+    "                         [--engine cellular|margolus|intent]\n"
+    "scenes: sand_avalanche, water_basin, gas_plumes, mixed_chaos, idle_95\n";
+
+template <typename T>
+static bool parse_list(const char* text, std::vector<T>& out)
+{
+    out.clear();
+    std::stringstream in(text);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        std::istringstream value(item);
+        T v;
+        if (!(value >> v)) return false;
+        out.push_back(v);
+    }
+    return !out.empty();
+}
+
+static bool parse_args(int argc, char* argv[], BenchOptions& o)
+{
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const char* arg = argv[i];
+        const char* value = argv[i + 1];
+        bool ok = true;
+        if (strcmp(arg, "--frames") == 0) ok = sscanf(value, "%u", &o.frames) == 1;
+        else if (strcmp(arg, "--warmup") == 0) ok = sscanf(value, "%u", &o.warmup) == 1;
+        else if (strcmp(arg, "--sizes") == 0) ok = parse_list(value, o.sizes);
+        else if (strcmp(arg, "--threads") == 0) ok = parse_list(value, o.threads);
+        else if (strcmp(arg, "--scenes") == 0) ok = parse_list(value, o.scenes);
+        else if (strcmp(arg, "--out") == 0) o.out = value;
+        else if (strcmp(arg, "--simd") == 0) ok = parse_simd_level(value, &o.simd);
+        else if (strcmp(arg, "--engine") == 0) {
+            if (strcmp(value, "cellular") == 0) o.engine = SIM_ENGINE_CELLULAR;
+            else if (strcmp(value, "margolus") == 0) o.engine = SIM_ENGINE_MARGOLUS;
+            else if (strcmp(value, "intent") == 0) o.engine = SIM_ENGINE_INTENT;
+            else ok = false;
+        }
+        else ok = false;
+        if (!ok) {
+            spdlog::error("Invalid argument: {} {}", arg, value);
+            return false;
+        }
+    }
+    if (argc % 2 == 0) {
+        spdlog::error("Missing value for {}", argv[argc - 1]);
+        return false;
+    }
+    return true;
+}
+
+static BenchResult run_case(const BenchScene& scene, int32_t size, uint32_t threads, const BenchOptions& o)
+{
+    // 世界宽高比 2:1，接近主程序的纹理尺寸
+    int32_t w = size;
+    int32_t h = size / 2;
+
+    ParticleSimulator sim(w, h);
+    sim.set_thread_count(threads);
+    sim.set_seed(1);
+    sim.set_engine(o.engine);
+    scene.build(sim, w, h);
+
+    for (uint32_t f = 0; f < o.warmup; ++f) {
+        if (scene.step) scene.step(sim, w, h, sim.frame());
+        sim.step();
+        sim.refresh_output();
+    }
+
+    std::vector<double> frame_ns;
+    frame_ns.reserve(o.frames);
+    double total_ns = 0.0;
+    for (uint32_t f = 0; f < o.frames; ++f) {
+        if (scene.step) scene.step(sim, w, h, sim.frame());
+        // 与交互模式一样，每帧生成一次颜色输出
+        auto begin = std::chrono::steady_clock::now();
+        sim.step();
+        sim.refresh_output();
+        auto end = std::chrono::steady_clock::now();
+        double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+        frame_ns.push_back(ns);
+        total_ns += ns;
+    }
+    std::sort(frame_ns.begin(), frame_ns.end());
+
+    std::vector<PackedCell> cells;
+    sim.export_packed(cells);
+
+    BenchResult r = {};
+    r.scene = scene.name;
+    r.width = w;
+    r.height = h;
+    r.threads = sim.thread_count();
+    r.ns_per_cell_step = total_ns / ((double)o.frames * w * h);
+    r.steps_per_second = total_ns > 0.0 ? (double)o.frames * 1e9 / total_ns : 0.0;
+    r.frame_ms_p50 = frame_ns.empty() ? 0.0 : frame_ns[frame_ns.size() / 2] * 1e-6;
+    r.frame_ms_max = frame_ns.empty() ? 0.0 : frame_ns.back() * 1e-6;
+    r.hash = snapshot_hash(cells);
+    return r;
+}
+
+static bool write_json(const std::string& path, const BenchOptions& o, const std::vector<BenchResult>& results)
+{
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) {
+        spdlog::error("Failed to open output file: {}", path);
+        return false;
+    }
+
+    fprintf(file, "{\n");
+    fprintf(file, "  \"hardware_threads\": %u,\n", std::thread::hardware_concurrency());
+    fprintf(file, "  \"frames\": %u,\n  \"warmup\": %u,\n", o.frames, o.warmup);
+    fprintf(file, "  \"simd\": \"%s\",\n", simd_level_name(simd_level()));
+    static const char* engine_names[] = { "cellular", "margolus", "intent" };
+    fprintf(file, "  \"engine\": \"%s\",\n", engine_names[o.engine]);
+    fprintf(file, "  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        // 加速比相对于同一场景、同一尺寸的第一个线程数
+        const BenchResult* base = &r;
+        for (const BenchResult& b : results) {
+            if (b.scene == r.scene && b.width == r.width) { base = &b; break; }
+        }
+        fprintf(file,
+                "    { \"scene\": \"%s\", \"width\": %d, \"height\": %d, \"threads\": %u, "
+                "\"ns_per_cell_step\": %.4f, \"steps_per_second\": %.2f, \"speedup\": %.3f, "
+                "\"frame_ms_p50\": %.4f, \"frame_ms_max\": %.4f, \"world_hash\": \"%016llx\" }%s\n",
+                r.scene.c_str(), r.width, r.height, r.threads, r.ns_per_cell_step, r.steps_per_second,
+                base->steps_per_second > 0.0 ? r.steps_per_second / base->steps_per_second : 0.0,
+                r.frame_ms_p50, r.frame_ms_max, (unsigned long long)r.hash,
+                i + 1 < results.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    return fclose(file) == 0;
+}
+
+int main(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            fputs(k_usage, stdout);
+            return 0;
+        }
+    }
+
+    BenchOptions options;
+    if (!parse_args(argc, argv, options)) {
+        fputs(k_usage, stderr);
+        return 1;
+    }
+    simd_select(options.simd);
+
+    // 默认的线程数曲线：1, 2, 4, ... 直到硬件线程数
+    if (options.threads.empty()) {
+        uint32_t hw = std::max(1u, std::thread::hardware_concurrency());
+        for (uint32_t t = 1; t < hw; t *= 2) options.threads.push_back(t);
+        options.threads.push_back(hw);
+    }
+
+    std::vector<BenchResult> results;
+    bool deterministic = true;
+    for (const BenchScene& scene : k_scenes) {
+        if (!options.scenes.empty() &&
+            std::find(options.scenes.begin(), options.scenes.end(), scene.name) == options.scenes.end()) {
+            continue;
+        }
+        for (int32_t size : options.sizes) {
+            uint64_t first_hash = 0;
+            for (size_t t = 0; t < options.threads.size(); ++t) {
+                BenchResult r = run_case(scene, size, options.threads[t], options);
+                spdlog::info("{:>16} {:>5}x{:<5} {:>3} threads: {:8.3f} ns/cell/step {:10.1f} steps/s",
+                             r.scene, r.width, r.height, r.threads, r.ns_per_cell_step, r.steps_per_second);
+                if (t == 0) first_hash = r.hash;
+                if (r.hash != first_hash) {
+                    spdlog::error("{} {}x{}: world hash differs at {} threads", r.scene, r.width, r.height, r.threads);
+                    deterministic = false;
+                }
+                results.push_back(r);
+            }
+        }
+    }
+
+    if (!write_json(options.out, options, results)) return 1;
+    return deterministic ? 0 : 2;
+}
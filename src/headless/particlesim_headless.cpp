@@ -0,0 +1,27 @@
+// particlesim_headless：只链接模拟核心的无头运行程序。
+// 不依赖 SDL 和 Vulkan，没有安装图形库的计算节点上也能启动，参数见 sim/headless.h：
+//
+//   particlesim_headless <scenario> [--frames N] [--threads N] [--seed N]
+//                        [--timings timings.json] [--snapshot world.psnp] [--simd avx2]
+//   particlesim_headless --help
+#include <cstdio>
+#include <cstring>
+
+#include "sim/headless.h"
+
+int main(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            print_headless_usage(stdout, "particlesim_headless");
+            return 0;
+        }
+    }
+
+    HeadlessOptions options;
+    if (!parse_headless_args(argc, argv, options)) {
+        print_headless_usage(stderr, "particlesim_headless");
+        return 1;
+    }
+    return run_headless(options);
+}
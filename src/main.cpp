@@ -11,12 +11,19 @@
 #include "logger.h"
 
 #include "ParticleSim.h"
+#include "sim/headless.h"
+#include "sim/palette.h"
+#include "sim/sim_thread.h"
+#include "sim/simd.h"
 #include "render/render.h"
 // 常量定义
 static const int WINDOW_WIDTH = 1258;
 static const int WINDOW_HEIGHT = 848;
 static const int TEXTURE_WIDTH = 1258 >> 1;
 static const int TEXTURE_HEIGHT = 848 >> 1;
+// 调色板渲染：模拟器只输出 2 字节的材质 id 和颜色档，颜色在片元着色器中查表。
+// 渲染器的纹理路径还没有接入 Render::draw，目前两种格式都不会显示
+static const bool PALETTE_RENDER = true;
 
 class Application {
 public:
@@ -26,6 +33,7 @@ public:
     }
 
     ~Application() {
+        delete sim_thread;
         delete simulation;
         delete render;
         SDL_DestroyWindow(window);
@@ -33,18 +41,16 @@ public:
     }
 
     void run() {
-        auto lastTime = std::chrono::high_resolution_clock::now();
+        // 模拟在自己的线程上按固定步长运行，这里只取最新的一帧去渲染，两边互不等待
+        sim_thread->start();
         while (running) {
             handleEvents();
-            
-            auto currentTime = std::chrono::high_resolution_clock::now();
-            float deltaTime = std::chrono::duration<float>(currentTime - lastTime).count();
-            lastTime = currentTime;
 
-            update(deltaTime);
+            update();
             render->draw(windowSize);
             SDL_Delay(16); // 控制帧率
         }
+        sim_thread->stop();
     }
 
 private:
@@ -52,6 +58,9 @@ private:
     Render* render = NULL;
     vk::Extent2D windowSize { WINDOW_WIDTH, WINDOW_HEIGHT };
     ParticleSimulator* simulation = NULL;
+    SimulationThread* sim_thread = NULL;
+    uint64_t last_sequence = 0;                  // 上一次交给渲染器的帧号
+    std::vector<TextureRegion> texture_regions;
     bool running = true;
 
     void initSDL() {
@@ -61,11 +70,19 @@ private:
             SDL_WINDOW_VULKAN | SDL_WINDOW_RESIZABLE
         );
         render = new Render(window); // 创建渲染器
+        render->setTextureMode(PALETTE_RENDER ? TEXTURE_MODE_PALETTE : TEXTURE_MODE_RGBA);
         render->init(windowSize); // 初始化渲染器
     }
 
     void initSimulation() {
         simulation = new ParticleSimulator(TEXTURE_WIDTH, TEXTURE_HEIGHT); // 原始尺寸的一半
+        if (PALETTE_RENDER) {
+            simulation->set_output(SIM_OUTPUT_PALETTE);
+            std::vector<Color> palette;
+            build_palette(simulation->materials(), palette);
+            render->setPalette((const uint8_t*)palette.data(), PALETTE_WIDTH, PALETTE_HEIGHT, PALETTE_VIEW_COUNT);
+        }
+        sim_thread = new SimulationThread(simulation);
     }
 
     void handleEvents() {
@@ -94,6 +111,27 @@ private:
                             running = false;
                             break;
                         }
+                        case SDLK_T: {// 按下 T 键切换快进模式
+                            sim_thread->post([](ParticleSimulator& sim) {
+                                sim.m_turbo = !sim.m_turbo;
+                                SPDLOG_INFO("Turbo mode: {}", sim.m_turbo ? "on" : "off");
+                            });
+                            break;
+                        }
+                        case SDLK_M: {// 按下 M 键依次切换逐格更新、Margolus 块更新和意图裁决
+                            sim_thread->post([](ParticleSimulator& sim) {
+                                static const char* names[] = { "cellular", "margolus", "intent" };
+                                SimEngine engine = (SimEngine)((sim.engine() + 1) % SIM_ENGINE_COUNT);
+                                sim.set_engine(engine);
+                                SPDLOG_INFO("Simulation engine: {}", names[engine]);
+                            });
+                            break;
+                        }
+                        case SDLK_V: {// 按下 V 键切换调色板视图（颜色 / 热度 / 物态）
+                            render->setPaletteView((render->paletteView() + 1) % PALETTE_VIEW_COUNT);
+                            SPDLOG_INFO("Palette view: {}", render->paletteView());
+                            break;
+                        }
                         default: {
                             SPDLOG_INFO("Key pressed: {}", SDL_GetKeyName(event.key.key));
                             break;
@@ -131,8 +169,27 @@ private:
         }
     }
 
-    void update(float deltaTime) {
-        simulation->update(deltaTime);
+    void update() {
+        // 有新帧时交给渲染器，没有时渲染器继续使用上一帧
+        bool fresh = false;
+        const SimFrame* frame = sim_thread->frames().acquire(&fresh);
+        if (!fresh) return;
+
+        uint8_t* data = frame->output == SIM_OUTPUT_PALETTE ? (uint8_t*)frame->cells.data() : (uint8_t*)frame->colors.data();
+
+        // 区域相对的正是上一次交给渲染器的帧时只上传变化的区域，否则整张上传
+        if (frame->base_sequence == last_sequence) {
+            texture_regions.clear();
+            for (const SimRect& r : frame->regions) {
+                texture_regions.push_back(TextureRegion { (uint32_t)r.x0, (uint32_t)r.y0,
+                                                          (uint32_t)(r.x1 - r.x0 + 1), (uint32_t)(r.y1 - r.y0 + 1) });
+            }
+            render->setTextureData(data, TEXTURE_WIDTH, TEXTURE_HEIGHT,
+                                   texture_regions.data(), (uint32_t)texture_regions.size());
+        } else {
+            render->setTextureData(data, TEXTURE_WIDTH, TEXTURE_HEIGHT);
+        }
+        last_sequence = frame->sequence;
     }
 };
 
@@ -140,6 +197,26 @@ int main(int argc, char* argv[]) {
 
     setup_logger();
 
+    // 无头模式：只运行模拟，不初始化 SDL 窗口和 Vulkan
+    if (headless_requested(argc, argv)) {
+        HeadlessOptions options;
+        if (!parse_headless_args(argc, argv, options)) {
+            print_headless_usage(stderr, (std::string(argv[0]) + " --headless").c_str());
+            return 1;
+        }
+        return run_headless(options);
+    }
+
+    // --simd <level> 限制模拟内核可用的最高指令集，用于对比各级别或排查某一级别的问题
+    SimdLevel simd = SIMD_AVX512;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (strcmp(argv[i], "--simd") == 0 && !parse_simd_level(argv[i + 1], &simd)) {
+            SPDLOG_ERROR("Invalid value for --simd: {} (scalar, sse4.2, avx2, avx512, auto)", argv[i + 1]);
+            return 1;
+        }
+    }
+    simd_select(simd);
+
     Application app;
     app.run();
     return 0;
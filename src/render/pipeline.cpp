@@ -317,10 +317,17 @@ void Render::createMainPipeline() {
     dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
     dynamicState.pDynamicStates = dynamicStates.data();
     
-    // 管线布局
+    // 管线布局：push constant 选择调色板模式和视图，大小与 UI 管线相同
+    vk::PushConstantRange pushConstantRange;
+    pushConstantRange.stageFlags = vk::ShaderStageFlagBits::eFragment;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(MainPushConstants);
+
     vk::PipelineLayoutCreateInfo pipelineLayoutInfo;
     pipelineLayoutInfo.setLayoutCount = 1;
     pipelineLayoutInfo.pSetLayouts = &m_descriptor_set_layout;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
     
     m_pipeline_layout = VK_ERROR_CHECK(m_LogicalDevice.createPipelineLayout(pipelineLayoutInfo),"createMainPipeline: Failed to create pipeline layout!");
     
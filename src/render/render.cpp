@@ -29,9 +29,11 @@ void Render::init(vk::Extent2D& windowSize) {
         Render::createFrameBuffers(windowSize);
         Render::createPipeline();
 
+        // 纹理路径（暂存环、按区域上传、R8G8 调色板纹理、main.frag 的 push constant）还没有接入：
+        // initResources 需要先知道纹理尺寸，main.vert 还不是合法的 Vulkan GLSL，main/ui 着色器也没有编译成 SPIR-V。
+        // 接入之前 draw 只画三角形，setTextureData 和 setPalette 的数据不会显示
         //Render::initResources();
 
-
     } catch(const std::runtime_error& error) {
         spdlog::error("Vulkan init error: {}", error.what());
     }
@@ -161,51 +163,72 @@ void Render::draw_custom(vk::Extent2D& windowSize) {
     beginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
     cmd.begin(beginInfo);
 
-	// 1. 纹理数据更新
-    if (g_texture_buffer && g_texture_width > 0 && g_texture_height > 0)
+    // 调色板只在材质变化后上传一次
+    if (m_palette_dirty) uploadPalette();
+
+	// 1. 纹理数据更新：本帧的栅栏已经等待过，GPU 不会再读这一格暂存区，
+	//    直接写入常驻映射的内存后复制到纹理。纹理布局在帧之间保持不变，内容不会被丢弃
+    if (m_texture_dirty && g_texture_buffer && g_texture_width > 0 && g_texture_height > 0)
     {
-        // 创建临时缓冲区和内存
-        vk::DeviceSize bufferSize = g_texture_width * g_texture_height * 4;
-        
-        vk::Buffer stagingBuffer;
-        vk::DeviceMemory stagingMemory;
-        createBuffer(bufferSize, 
-                     vk::BufferUsageFlagBits::eTransferSrc,
-                     vk::MemoryPropertyFlagBits::eHostVisible | 
-                     vk::MemoryPropertyFlagBits::eHostCoherent,
-                     stagingBuffer, stagingMemory);
-        
-        // 映射内存并复制数据
-        void* data;
-        vkMapMemory(m_LogicalDevice, stagingMemory, 0, bufferSize, 0, &data);
-        memcpy(data, g_texture_buffer, static_cast<size_t>(bufferSize));
-        vkUnmapMemory(m_LogicalDevice, stagingMemory);
-        
-        // 复制到纹理
-        transitionImageLayout(cmd, g_tex.image, 
-                             vk::ImageLayout::eUndefined, 
-                             vk::ImageLayout::eTransferDstOptimal);
-        
+        StagingBuffer& staging = m_texture_staging[m_CurrentFrame];
+        uint32_t bpp = textureBytesPerTexel();
+        vk::DeviceSize bufferSize = (vk::DeviceSize)g_texture_width * g_texture_height * bpp;
+
+        // 变化面积超过阈值时逐区域复制不再划算，整张上传
+        uint64_t changed = 0;
+        for (const TextureRegion& r : m_texture_regions) changed += (uint64_t)r.width * r.height;
+        bool full = m_texture_full_upload ||
+                    changed > (uint64_t)(m_texture_region_threshold * g_texture_width * g_texture_height);
+
         vk::BufferImageCopy region{};
+        region.bufferRowLength = g_texture_width;
+        region.bufferImageHeight = g_texture_height;
         region.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
         region.imageSubresource.mipLevel = 0;
         region.imageSubresource.baseArrayLayer = 0;
         region.imageSubresource.layerCount = 1;
-        region.imageExtent.width = g_texture_width;
-        region.imageExtent.height = g_texture_height;
         region.imageExtent.depth = 1;
-        
-        cmd.copyBufferToImage(stagingBuffer, g_tex.image, 
-                             vk::ImageLayout::eTransferDstOptimal, 
-                             1, &region);
-        
-        transitionImageLayout(cmd, g_tex.image, 
-                             vk::ImageLayout::eTransferDstOptimal, 
-                             vk::ImageLayout::eShaderReadOnlyOptimal);
-        
-        // 清理临时资源
-        m_LogicalDevice.destroyBuffer(stagingBuffer);
-        m_LogicalDevice.freeMemory(stagingMemory);
+
+        // 暂存区与纹理布局相同，区域在两边的偏移一致；暂存区中其他位置的旧数据不会被复制
+        m_texture_copies.clear();
+        if (bufferSize > staging.size) {
+            spdlog::error("Texture data ({} bytes) exceeds the staging buffer ({} bytes)", bufferSize, staging.size);
+        } else if (full) {
+            memcpy(staging.mapped, g_texture_buffer, static_cast<size_t>(bufferSize));
+            region.imageExtent.width = g_texture_width;
+            region.imageExtent.height = g_texture_height;
+            m_texture_copies.push_back(region);
+        } else {
+            size_t pitch = (size_t)g_texture_width * bpp;
+            for (const TextureRegion& r : m_texture_regions) {
+                size_t offset = (size_t)r.y * pitch + (size_t)r.x * bpp;
+                for (uint32_t row = 0; row < r.height; ++row) {
+                    memcpy(staging.mapped + offset + row * pitch, g_texture_buffer + offset + row * pitch, (size_t)r.width * bpp);
+                }
+                region.bufferOffset = offset;
+                region.imageOffset = vk::Offset3D{ (int32_t)r.x, (int32_t)r.y, 0 };
+                region.imageExtent.width = r.width;
+                region.imageExtent.height = r.height;
+                m_texture_copies.push_back(region);
+            }
+        }
+        m_texture_dirty = false;
+        m_texture_full_upload = false;
+        m_texture_regions.clear();
+
+        if (!m_texture_copies.empty()) {
+            transitionImageLayout(cmd, g_tex.image, 
+                                 vk::ImageLayout::eShaderReadOnlyOptimal, 
+                                 vk::ImageLayout::eTransferDstOptimal);
+
+            cmd.copyBufferToImage(staging.buffer, g_tex.image, 
+                                 vk::ImageLayout::eTransferDstOptimal, 
+                                 (uint32_t)m_texture_copies.size(), m_texture_copies.data());
+
+            transitionImageLayout(cmd, g_tex.image, 
+                                 vk::ImageLayout::eTransferDstOptimal, 
+                                 vk::ImageLayout::eShaderReadOnlyOptimal);
+        }
     }
 
     // 2. 主场景渲染
@@ -250,6 +273,13 @@ void Render::draw_custom(vk::Extent2D& windowSize) {
         cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, 
                              m_pipeline_layout, 
                              0, 1, &m_main_descriptor_set, 0, nullptr);
+
+        // 调色板模式和当前视图
+        MainPushConstants constants{};
+        constants.palette_mode = m_texture_mode == TEXTURE_MODE_PALETTE ? 1 : 0;
+        constants.palette_view = (int32_t)std::min(m_palette_view, m_palette_views - 1);
+        constants.rows_per_view = (int32_t)(m_palette_height / m_palette_views);
+        cmd.pushConstants(m_pipeline_layout, vk::ShaderStageFlagBits::eFragment, 0, sizeof(constants), &constants);
         
         // 绘制命令
         cmd.drawIndexed(6, 1, 0, 0, 0);
@@ -332,6 +362,107 @@ void Render::draw_custom(vk::Extent2D& windowSize) {
 
 }
 
+void Render::setTextureData(uint8_t* data, uint32_t width, uint32_t height,
+                            const TextureRegion* regions, uint32_t count) {
+    // 尺寸变化或者上一次的数据还没上传就被整张替换过时，只能整张上传
+    bool full = m_texture_dirty && m_texture_full_upload;
+    if (width != g_texture_width || height != g_texture_height) full = true;
+    if (!m_texture_dirty) m_texture_regions.clear();
+
+    g_texture_buffer = data;
+    g_texture_width = width;
+    g_texture_height = height;
+    m_texture_dirty = true;
+    m_texture_full_upload = full;
+    if (full) return;
+
+    for (uint32_t i = 0; i < count; ++i) {
+        TextureRegion r = regions[i];
+        if (r.x >= width || r.y >= height) continue;
+        r.width = std::min(r.width, width - r.x);
+        r.height = std::min(r.height, height - r.y);
+        if (r.width > 0 && r.height > 0) m_texture_regions.push_back(r);
+    }
+}
+
+void Render::createTextureStaging() {
+    vk::DeviceSize bufferSize = (vk::DeviceSize)g_texture_width * g_texture_height * textureBytesPerTexel();
+    for (StagingBuffer& staging : m_texture_staging) {
+        createBuffer(bufferSize, 
+                     vk::BufferUsageFlagBits::eTransferSrc,
+                     vk::MemoryPropertyFlagBits::eHostVisible | 
+                     vk::MemoryPropertyFlagBits::eHostCoherent,
+                     staging.buffer, staging.memory);
+        // 映射一次，直到销毁都不解除
+        void* data;
+        vkMapMemory(m_LogicalDevice, staging.memory, 0, bufferSize, 0, &data);
+        staging.mapped = static_cast<uint8_t*>(data);
+        staging.size = bufferSize;
+    }
+}
+
+void Render::setPalette(const uint8_t* data, uint32_t width, uint32_t height, uint32_t view_count) {
+    m_palette_data.assign(data, data + (size_t)width * height * 4);
+    m_palette_width = width;
+    m_palette_height = height;
+    m_palette_views = std::max(view_count, 1u);
+    m_palette_dirty = true;
+}
+
+void Render::uploadPalette() {
+    m_palette_dirty = false;
+    if (m_palette_data.empty()) return;
+
+    // 调色板很少变化，直接等设备空闲后重建，不占用每帧的暂存环
+    if (g_tex_palette.image) {
+        m_LogicalDevice.waitIdle();
+        destroyTexture(g_tex_palette);
+    }
+    createTexture(g_tex_palette, m_palette_width, m_palette_height,
+                  vk::Format::eR8G8B8A8Unorm,
+                  vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst,
+                  m_palette_data.data());
+    updateMainDescriptors();
+}
+
+void Render::updateMainDescriptors() {
+    // binding 0：主纹理；binding 1：调色板，还没有调色板时先绑定主纹理占位，保证描述符始终有效
+    vk::DescriptorImageInfo imageInfos[2];
+    imageInfos[0] = vk::DescriptorImageInfo(g_tex.sampler, g_tex.view, vk::ImageLayout::eShaderReadOnlyOptimal);
+    imageInfos[1] = g_tex_palette.image
+        ? vk::DescriptorImageInfo(g_tex_palette.sampler, g_tex_palette.view, vk::ImageLayout::eShaderReadOnlyOptimal)
+        : imageInfos[0];
+
+    vk::WriteDescriptorSet writes[2];
+    for (uint32_t i = 0; i < 2; ++i) {
+        writes[i].dstSet = m_main_descriptor_set;
+        writes[i].dstBinding = i;
+        writes[i].dstArrayElement = 0;
+        writes[i].descriptorType = vk::DescriptorType::eCombinedImageSampler;
+        writes[i].descriptorCount = 1;
+        writes[i].pImageInfo = &imageInfos[i];
+    }
+    m_LogicalDevice.updateDescriptorSets(2, writes, 0, nullptr);
+}
+
+void Render::destroyTexture(Texture& tex) {
+    m_LogicalDevice.destroySampler(tex.sampler);
+    m_LogicalDevice.destroyImageView(tex.view);
+    m_LogicalDevice.destroyImage(tex.image);
+    m_LogicalDevice.freeMemory(tex.memory);
+    tex = Texture{};
+}
+
+void Render::destroyTextureStaging() {
+    for (StagingBuffer& staging : m_texture_staging) {
+        if (!staging.buffer) continue;
+        vkUnmapMemory(m_LogicalDevice, staging.memory);
+        m_LogicalDevice.destroyBuffer(staging.buffer);
+        m_LogicalDevice.freeMemory(staging.memory);
+        staging = StagingBuffer{};
+    }
+}
+
 void Render::draw_ui(vk::Extent2D &windowSize)
 {
     // 开始UI渲染通道
@@ -550,6 +681,7 @@ void Render::createTexture(Texture& tex, uint32_t width, uint32_t height,
     
     // 如果有初始数据，上传到纹理
     if (initialData) {
+        vk::DeviceSize dataSize = (vk::DeviceSize)width * height * (format == vk::Format::eR8G8Unorm ? 2 : 4);
         vk::CommandBuffer cmd = beginSingleTimeCommands();
         
         // 转换图像布局
@@ -560,7 +692,7 @@ void Render::createTexture(Texture& tex, uint32_t width, uint32_t height,
         // 创建暂存缓冲区
         vk::Buffer stagingBuffer;
         vk::DeviceMemory stagingMemory;
-        createBuffer(width * height * 4, 
+        createBuffer(dataSize, 
                     vk::BufferUsageFlagBits::eTransferSrc,
                     vk::MemoryPropertyFlagBits::eHostVisible | 
                     vk::MemoryPropertyFlagBits::eHostCoherent,
@@ -568,8 +700,8 @@ void Render::createTexture(Texture& tex, uint32_t width, uint32_t height,
         
         // 复制数据到暂存缓冲区
         void* data;
-        vkMapMemory(m_LogicalDevice, stagingMemory, 0, width * height * 4, 0, &data);
-        memcpy(data, initialData, static_cast<size_t>(width * height * 4));
+        vkMapMemory(m_LogicalDevice, stagingMemory, 0, dataSize, 0, &data);
+        memcpy(data, initialData, static_cast<size_t>(dataSize));
         vkUnmapMemory(m_LogicalDevice, stagingMemory);
         
         // 从缓冲区复制到图像
@@ -604,20 +736,23 @@ void Render::createTexture(Texture& tex, uint32_t width, uint32_t height,
 void Render::initResources() {
     
     // 创建描述符集布局
-    vk::DescriptorSetLayoutBinding samplerBinding;
-    samplerBinding.binding = 0;
-    samplerBinding.descriptorType = vk::DescriptorType::eCombinedImageSampler;
-    samplerBinding.descriptorCount = 1;
-    samplerBinding.stageFlags = vk::ShaderStageFlagBits::eFragment;
+    // binding 0 为纹理，binding 1 为主场景调色板模式使用的调色板
+    vk::DescriptorSetLayoutBinding samplerBindings[2];
+    for (uint32_t i = 0; i < 2; ++i) {
+        samplerBindings[i].binding = i;
+        samplerBindings[i].descriptorType = vk::DescriptorType::eCombinedImageSampler;
+        samplerBindings[i].descriptorCount = 1;
+        samplerBindings[i].stageFlags = vk::ShaderStageFlagBits::eFragment;
+    }
     vk::DescriptorSetLayoutCreateInfo layoutInfo;
-    layoutInfo.bindingCount = 1;
-    layoutInfo.pBindings = &samplerBinding;
+    layoutInfo.bindingCount = 2;
+    layoutInfo.pBindings = samplerBindings;
     
     m_descriptor_set_layout = VK_ERROR_CHECK(m_LogicalDevice.createDescriptorSetLayout(layoutInfo), "Failed to create descriptor set layout");
     // 创建描述符池
     vk::DescriptorPoolSize poolSize;
     poolSize.type = vk::DescriptorType::eCombinedImageSampler;
-    poolSize.descriptorCount = 3; // 主纹理、UI纹理和渲染目标
+    poolSize.descriptorCount = 4; // 主纹理、调色板、UI纹理和渲染目标
     
     vk::DescriptorPoolCreateInfo poolInfo;
     poolInfo.poolSizeCount = 1;
@@ -681,17 +816,19 @@ void Render::initResources() {
                 m_DynamicVertexBuffer, m_DynamicVertexBufferMemory);
 
     // 初始化纹理缓冲区
-    g_texture_buffer = new uint8_t[g_texture_width * g_texture_height * 4];
-    memset(g_texture_buffer, 0, g_texture_width * g_texture_height * 4);
+    g_texture_buffer = new uint8_t[g_texture_width * g_texture_height * textureBytesPerTexel()];
+    memset(g_texture_buffer, 0, g_texture_width * g_texture_height * textureBytesPerTexel());
 
     g_ui_buffer = new uint8_t[g_texture_width * g_texture_height * 4];
     memset(g_ui_buffer, 0, g_texture_width * g_texture_height * 4);
     
     // 创建主纹理
     createTexture(g_tex, g_texture_width, g_texture_height, 
-                 vk::Format::eR8G8B8A8Unorm, 
+                 m_texture_mode == TEXTURE_MODE_PALETTE ? vk::Format::eR8G8Unorm : vk::Format::eR8G8B8A8Unorm, 
                  vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst,
                  g_texture_buffer);
+    createTextureStaging();
+    updateMainDescriptors();
     // 创建UI纹理
     createTexture(g_tex_ui, g_texture_width, g_texture_height, 
                  vk::Format::eR8G8B8A8Unorm, 
@@ -715,6 +852,9 @@ void Render::initResources() {
 
 void Render::cleanResources()
 {
+    destroyTextureStaging();
+    if (g_tex_palette.image) destroyTexture(g_tex_palette);
+
     // 销毁描述符集
     m_LogicalDevice.destroyDescriptorSetLayout(m_descriptor_set_layout);
     m_LogicalDevice.destroyDescriptorPool(m_descriptor_pool);
@@ -985,6 +1125,13 @@ void Render::transitionImageLayout(vk::CommandBuffer cmd, vk::Image image,
         barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
         sourceStage = vk::PipelineStageFlagBits::eTransfer;
         destinationStage = vk::PipelineStageFlagBits::eFragmentShader;
+    } else if (oldLayout == vk::ImageLayout::eShaderReadOnlyOptimal && 
+               newLayout == vk::ImageLayout::eTransferDstOptimal) {
+        // 保留已有内容的局部更新：等上一帧的采样结束再写入
+        barrier.srcAccessMask = vk::AccessFlagBits::eShaderRead;
+        barrier.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
+        sourceStage = vk::PipelineStageFlagBits::eFragmentShader;
+        destinationStage = vk::PipelineStageFlagBits::eTransfer;
     } else if (oldLayout == vk::ImageLayout::eShaderReadOnlyOptimal && 
                newLayout == vk::ImageLayout::eTransferSrcOptimal) {
         barrier.srcAccessMask = vk::AccessFlagBits::eShaderRead;
@@ -27,6 +27,34 @@ struct Texture {
     uint32_t height;
 };
 
+// 常驻映射的暂存缓冲区
+struct StagingBuffer {
+    vk::Buffer buffer;
+    vk::DeviceMemory memory;
+    uint8_t* mapped = nullptr;
+    vk::DeviceSize size = 0;
+};
+
+// 主纹理的内容
+enum TextureMode {
+    TEXTURE_MODE_RGBA = 0,  // R8G8B8A8，每格 4 字节颜色
+    TEXTURE_MODE_PALETTE    // R8G8，每格 2 字节（材质 id、颜色档），main.frag 查调色板得到颜色
+};
+
+// main.frag 的 push constant，与 UI 管线共用 16 字节的片元阶段范围
+struct MainPushConstants {
+    int32_t palette_mode;
+    int32_t palette_view;
+    int32_t rows_per_view;
+    int32_t padding;
+};
+
+// 纹理中的一块矩形区域（像素）
+struct TextureRegion {
+    uint32_t x, y;
+    uint32_t width, height;
+};
+
 // 添加GlyphInfo结构定义
 struct GlyphInfo {
     float x0, y0;   // 纹理坐标起始位置
@@ -76,6 +104,7 @@ class Render {
         void init(vk::Extent2D& windowSize);
         void resize(vk::Extent2D& newWindowSize);
         void draw(vk::Extent2D& windowSize);
+        // 纹理上传和调色板的绘制路径，还没有接入 init 和 draw，见 Render::init
         void draw_custom(vk::Extent2D& windowSize);
         void draw_offscreen(vk::Extent2D& windowSize);
         void draw_postprocess(vk::Extent2D& windowSize);
@@ -83,13 +112,31 @@ class Render {
         void drawText(vk::CommandBuffer cmd, const std::string& text, 
                  float x, float y, float scale, const float color[4]);
 
-        // 设置纹理数据
+        // 选择主纹理的格式，必须在 initResources 之前调用
+        void setTextureMode(TextureMode mode) { m_texture_mode = mode; }
+        uint32_t textureBytesPerTexel() const { return m_texture_mode == TEXTURE_MODE_PALETTE ? 2 : 4; }
+
+        // 设置调色板（RGBA，width * height），纵向分成 view_count 个视图，下一次 draw_custom 时上传
+        void setPalette(const uint8_t* data, uint32_t width, uint32_t height, uint32_t view_count);
+
+        // 切换调色板视图，只改 push constant，不重新上传任何数据
+        void setPaletteView(uint32_t view) { m_palette_view = view; }
+        uint32_t paletteView() const { return m_palette_view; }
+
+        // 设置纹理数据（每格 textureBytesPerTexel() 字节），下一次 draw_custom 时复制到暂存环并上传
         void setTextureData(uint8_t* data, uint32_t width, uint32_t height) {
             g_texture_buffer = data;
             g_texture_width = width;
             g_texture_height = height;
+            m_texture_dirty = true;
+            m_texture_full_upload = true;
         }
 
+        // 同上，但只有 regions 中的区域相对已上传的内容发生了变化，draw_custom 只复制这些区域。
+        // 两次 draw 之间多次调用时区域会累积；变化面积超过 m_texture_region_threshold 时整张上传
+        void setTextureData(uint8_t* data, uint32_t width, uint32_t height,
+                            const TextureRegion* regions, uint32_t count);
+
     private:
         bool m_DebugLayer = false;
         vk::detail::DispatchLoaderDynamic m_Dispatcher;
@@ -148,6 +195,11 @@ class Render {
         void cleanResources();
         vk::CommandBuffer beginSingleTimeCommands();
         void endSingleTimeCommands(vk::CommandBuffer &commandBuffer);
+        void createTextureStaging();
+        void destroyTextureStaging();
+        void uploadPalette();
+        void updateMainDescriptors();
+        void destroyTexture(Texture& tex);
         void createTexture(Texture& tex, uint32_t width, uint32_t height, 
                           vk::Format format, vk::ImageUsageFlags usage, 
                           void* initialData);
@@ -180,7 +232,26 @@ class Render {
         uint32_t g_texture_width = 0;
         uint32_t g_texture_height = 0;
 
+        // 主纹理的暂存环，每个并发帧一个，创建一次后一直映射；
+        // 主纹理在帧之间保持 eShaderReadOnlyOptimal，内容保留，没有新数据时不上传
+        StagingBuffer m_texture_staging[MAX_FRAMES_IN_FLIGHT];
+        bool m_texture_dirty = false;   // g_texture_buffer 有未上传的数据
+        bool m_texture_full_upload = false;             // 待上传的数据需要整张上传
+        std::vector<TextureRegion> m_texture_regions;   // 否则只上传这些区域
+        std::vector<vk::BufferImageCopy> m_texture_copies;
+        float m_texture_region_threshold = 0.5f;        // 变化面积占整张纹理的比例上限
+        TextureMode m_texture_mode = TEXTURE_MODE_RGBA;
+
+        // 调色板模式：调色板只在材质变化时上传，切换视图不需要上传
+        std::vector<uint8_t> m_palette_data;
+        uint32_t m_palette_width = 0;
+        uint32_t m_palette_height = 0;
+        uint32_t m_palette_views = 1;
+        uint32_t m_palette_view = 0;
+        bool m_palette_dirty = false;
+
         Texture g_tex;  // 主纹理
+        Texture g_tex_palette; // 调色板纹理
         Texture g_tex_ui; // UI纹理
         Texture g_rt;    // 渲染目标纹理
         Texture g_tex_font; // 字体纹理
@@ -0,0 +1,164 @@
+#include "headless.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+#include "ParticleSim.h"
+#include "material_registry.h"
+#include "scenario.h"
+#include "snapshot.h"
+
+bool headless_requested(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--headless") == 0) return true;
+    }
+    return false;
+}
+
+bool parse_headless_args(int argc, char* argv[], HeadlessOptions& out) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (arg[0] != '-' && out.scenario.empty()) {
+            out.scenario = arg;
+            continue;
+        }
+        if (strcmp(arg, "--headless") != 0 && strcmp(arg, "--frames") != 0 && strcmp(arg, "--threads") != 0 &&
+            strcmp(arg, "--seed") != 0 && strcmp(arg, "--timings") != 0 && strcmp(arg, "--snapshot") != 0 &&
+            strcmp(arg, "--simd") != 0) {
+            spdlog::error("Unknown argument: {}", arg);
+            return false;
+        }
+        if (!value) {
+            spdlog::error("Missing value for {}", arg);
+            return false;
+        }
+        ++i;
+
+        if (strcmp(arg, "--headless") == 0) out.scenario = value;
+        else if (strcmp(arg, "--timings") == 0) out.timings_path = value;
+        else if (strcmp(arg, "--snapshot") == 0) out.snapshot_path = value;
+        else if (strcmp(arg, "--simd") == 0) {
+            if (!parse_simd_level(value, &out.simd)) {
+                spdlog::error("Invalid value for {}: {}", arg, value);
+                return false;
+            }
+        }
+        else {
+            char* end = nullptr;
+            long long n = strtoll(value, &end, 0);
+            if (*end != '\0' || n < 0) {
+                spdlog::error("Invalid value for {}: {}", arg, value);
+                return false;
+            }
+            if (strcmp(arg, "--frames") == 0) out.frames = n;
+            else if (strcmp(arg, "--threads") == 0) out.threads = n;
+            else out.seed = n;
+        }
+    }
+    return !out.scenario.empty();
+}
+
+void print_headless_usage(FILE* out, const char* command) {
+    fprintf(out,
+            "usage: %s <scenario> [--frames N] [--threads N] [--seed N]\n"
+            "       [--timings path] [--snapshot path] [--simd scalar|sse4.2|avx2|avx512|auto]\n",
+            command);
+}
+
+static std::string json_escape(const std::string& text) {
+    std::string out;
+    for (char c : text) {
+        if (c == '"' || c == '\\') out.push_back('\\');
+        out.push_back(c);
+    }
+    return out;
+}
+
+// 计时结果写成 JSON，方便参数扫描脚本直接读取
+static bool write_timings(const std::string& path, const Scenario& scenario, uint32_t threads,
+                          std::vector<double>& frame_ns, double total_ns, uint64_t hash) {
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) {
+        spdlog::error("Failed to open timings file: {}", path);
+        return false;
+    }
+
+    size_t n = frame_ns.size();
+    std::sort(frame_ns.begin(), frame_ns.end());
+    auto percentile = [&](double p) { return n ? frame_ns[std::min(n - 1, (size_t)(p * (double)n))] : 0.0; };
+    double cells = (double)scenario.width * scenario.height;
+    double mean = n ? total_ns / (double)n : 0.0;
+
+    fprintf(file, "{\n");
+    fprintf(file, "  \"scenario\": \"%s\",\n", json_escape(scenario.name).c_str());
+    fprintf(file, "  \"width\": %d,\n  \"height\": %d,\n", scenario.width, scenario.height);
+    fprintf(file, "  \"seed\": %llu,\n", (unsigned long long)scenario.seed);
+    fprintf(file, "  \"frames\": %zu,\n  \"threads\": %u,\n", n, threads);
+    fprintf(file, "  \"simd\": \"%s\",\n", simd_level_name(simd_level()));
+    fprintf(file, "  \"total_ms\": %.3f,\n", total_ns * 1e-6);
+    fprintf(file, "  \"steps_per_second\": %.3f,\n", total_ns > 0.0 ? (double)n * 1e9 / total_ns : 0.0);
+    fprintf(file, "  \"ns_per_cell_step\": %.4f,\n", mean / cells);
+    fprintf(file, "  \"frame_ms\": { \"min\": %.4f, \"mean\": %.4f, \"p50\": %.4f, \"p99\": %.4f, \"max\": %.4f },\n",
+            percentile(0.0) * 1e-6, mean * 1e-6, percentile(0.5) * 1e-6, percentile(0.99) * 1e-6,
+            n ? frame_ns.back() * 1e-6 : 0.0);
+    fprintf(file, "  \"world_hash\": \"%016llx\"\n", (unsigned long long)hash);
+    fprintf(file, "}\n");
+    return fclose(file) == 0;
+}
+
+int run_headless(const HeadlessOptions& options) {
+    Scenario scenario;
+    if (!load_scenario(options.scenario, scenario)) return 1;
+    if (options.frames >= 0) scenario.frames = (uint32_t)options.frames;
+    if (options.threads >= 0) scenario.threads = (uint32_t)options.threads;
+    if (options.seed >= 0) scenario.seed = (uint64_t)options.seed;
+    simd_select(options.simd);
+
+    ParticleSimulator sim(scenario.width, scenario.height);
+    sim.load_materials(scenario.materials);
+    for (const ScenarioBrush& b : scenario.brushes) {
+        if (sim.materials().find(b.material) < 0) {
+            spdlog::error("{}: unknown material '{}'", scenario.name, b.material);
+            return 1;
+        }
+    }
+    sim.set_thread_count(scenario.threads);
+    sim.set_seed(scenario.seed);
+    sim.m_tick_rate = 1.f / scenario.dt;
+
+    spdlog::info("Headless run: {} ({}x{}, {} frames, {} threads, seed {})", scenario.name, scenario.width,
+                 scenario.height, scenario.frames, sim.thread_count(), scenario.seed);
+
+    // 笔刷不计入帧时间，只统计模拟本身
+    std::vector<double> frame_ns;
+    frame_ns.reserve(scenario.frames);
+    double total_ns = 0.0;
+    for (uint32_t f = 0; f < scenario.frames; ++f) {
+        apply_scenario_brushes(scenario, sim, f);
+
+        // 与交互模式一样，每帧生成一次颜色输出
+        auto begin = std::chrono::steady_clock::now();
+        sim.step();
+        sim.refresh_output();
+        auto end = std::chrono::steady_clock::now();
+
+        double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+        frame_ns.push_back(ns);
+        total_ns += ns;
+    }
+
+    std::vector<PackedCell> cells;
+    sim.export_packed(cells);
+    uint64_t hash = snapshot_hash(cells);
+
+    bool ok = write_timings(options.timings_path, scenario, sim.thread_count(), frame_ns, total_ns, hash);
+    ok = write_snapshot(options.snapshot_path, sim) && ok;
+
+    spdlog::info("Headless run finished: {:.1f} ms, {:.1f} steps/s, world hash {:016x}", total_ns * 1e-6,
+                 total_ns > 0.0 ? scenario.frames * 1e9 / total_ns : 0.0, hash);
+    return ok ? 0 : 1;
+}
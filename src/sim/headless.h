@@ -0,0 +1,35 @@
+#pragma once
+#include <stdint.h>
+#include <cstdio>
+#include <string>
+
+#include "simd.h"
+
+// 无头运行：不创建窗口和渲染器，按场景文件以最快速度运行 N 帧，
+// 输出计时结果（JSON）和最终的世界快照。
+// particlesim_headless 只链接模拟核心，可以在没有 SDL 和 Vulkan 的机器上运行；主程序的 --headless 参数相同。
+//
+//   particlesim_headless <scenario> [--frames N] [--threads N] [--seed N]
+//                        [--timings timings.json] [--snapshot world.psnp] [--simd avx2]
+//   ParticleSim --headless <scenario> ...
+struct HeadlessOptions {
+    std::string scenario;
+    std::string timings_path = "timings.json";
+    std::string snapshot_path = "snapshot.psnp";
+    int64_t frames = -1;  // -1 表示使用场景中的值，下同
+    int64_t threads = -1;
+    int64_t seed = -1;
+    SimdLevel simd = SIMD_AVX512;  // 内核可用的最高指令集，不超过 CPU 支持的级别
+};
+
+// 命令行中是否带有 --headless
+bool headless_requested(int argc, char* argv[]);
+
+// 解析命令行，场景可以由 --headless 给出，也可以是单独的参数；参数错误时返回 false
+bool parse_headless_args(int argc, char* argv[], HeadlessOptions& out);
+
+// 打印命令行用法，command 为参数之前的部分，例如 "particlesim_headless"
+void print_headless_usage(FILE* out, const char* command);
+
+// 返回进程退出码
+int run_headless(const HeadlessOptions& options);
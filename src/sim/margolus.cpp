@@ -0,0 +1,78 @@
+#include "margolus.h"
+#include <utility>
+
+static bool movable(uint8_t c) {
+    return c != MARGOLUS_SOLID;
+}
+
+static uint8_t build_rule(const uint8_t classes[4], uint32_t variant) {
+    uint8_t c[4] = { classes[0], classes[1], classes[2], classes[3] };
+    uint8_t src[4] = { 0, 1, 2, 3 };
+    bool moved[4] = {};
+    auto swap = [&](int32_t a, int32_t b) {
+        std::swap(c[a], c[b]);
+        std::swap(src[a], src[b]);
+        moved[a] = moved[b] = true;
+    };
+    auto sinks = [&](int32_t top, int32_t bottom) {
+        return margolus_sinks(c[top], c[bottom]);
+    };
+
+    // 1. 竖直方向：上面比下面重就交换
+    if (sinks(0, 2)) swap(0, 2);
+    if (sinks(1, 3)) swap(1, 3);
+
+    // 2. 两列都没有竖直移动时，上面的格子被托住，对角比它轻就斜向滑落
+    if (!moved[0] && !moved[1]) {
+        static const int32_t diagonals[2][2] = { { 0, 3 }, { 1, 2 } };
+        for (uint32_t k = 0; k < 2; ++k) {
+            const int32_t* d = diagonals[(variant + k) & 1];
+            if (sinks(d[0], d[1])) {
+                swap(d[0], d[1]);
+                break;
+            }
+        }
+    }
+
+    // 3. 流体（液体、气体）与同一行里更稀的格子随机左右交换，液体由此展平
+    if (variant & 2) {
+        for (int32_t row = 0; row < 4; row += 2) {
+            int32_t a = row, b = row + 1;
+            if (moved[a] || moved[b] || c[a] == c[b] || !movable(c[a]) || !movable(c[b])) continue;
+            if (c[a] == MARGOLUS_POWDER || c[b] == MARGOLUS_POWDER) continue;
+            bool fluid = c[a] == MARGOLUS_LIQUID || c[a] == MARGOLUS_GAS || c[b] == MARGOLUS_LIQUID || c[b] == MARGOLUS_GAS;
+            if (fluid) swap(a, b);
+        }
+    }
+
+    return (uint8_t)(src[0] | (src[1] << 2) | (src[2] << 4) | (src[3] << 6));
+}
+
+static MargolusRules build_rules() {
+    MargolusRules rules;
+    for (uint32_t i = 0; i < MARGOLUS_COMBINATIONS; ++i) {
+        uint8_t classes[4];
+        uint32_t rest = i;
+        for (int32_t k = 0; k < 4; ++k) {
+            classes[k] = (uint8_t)(rest % MARGOLUS_CLASS_COUNT);
+            rest /= MARGOLUS_CLASS_COUNT;
+        }
+        for (uint32_t v = 0; v < MARGOLUS_VARIANTS; ++v) rules.perm[v][i] = build_rule(classes, v);
+    }
+    return rules;
+}
+
+const MargolusRules& margolus_rules() {
+    static const MargolusRules s_rules = build_rules();
+    return s_rules;
+}
+
+MargolusClass margolus_class(MaterialPhase phase) {
+    switch (phase) {
+    case PHASE_EMPTY: return MARGOLUS_EMPTY;
+    case PHASE_GAS: return MARGOLUS_GAS;
+    case PHASE_LIQUID: return MARGOLUS_LIQUID;
+    case PHASE_POWDER: return MARGOLUS_POWDER;
+    default: return MARGOLUS_SOLID;
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <stdint.h>
+
+#include "ParticleSim.h"
+
+// Margolus 邻域的 2x2 块元胞自动机规则。
+// 每个 tick 把网格划分成 2x2 的块，偶数 tick 块从 (0, 0) 开始，奇数 tick 从 (-1, -1) 开始；
+// 块内 4 个格子按运动类别的组合查表得到一个排列，块之间互不影响，不需要更新标记和扫描顺序。
+// 块内位置：0 左上，1 右上，2 左下，3 右下。
+
+// 运动类别，由材质的物态决定
+enum MargolusClass : uint8_t {
+    MARGOLUS_EMPTY = 0,
+    MARGOLUS_GAS,
+    MARGOLUS_LIQUID,
+    MARGOLUS_POWDER,
+    MARGOLUS_SOLID,     // 固体和幽灵格，永远不动
+    MARGOLUS_CLASS_COUNT
+};
+
+#define MARGOLUS_COMBINATIONS (MARGOLUS_CLASS_COUNT * MARGOLUS_CLASS_COUNT * MARGOLUS_CLASS_COUNT * MARGOLUS_CLASS_COUNT)
+// 每个块取 2 个随机位：第 0 位决定先试哪一侧的斜向滑落，第 1 位决定流体是否左右交换
+#define MARGOLUS_VARIANTS 4
+// 排列的第 i 个 2 位字段是位置 i 的新内容来自哪个位置
+#define MARGOLUS_IDENTITY 0xE4
+
+struct MargolusRules {
+    uint8_t perm[MARGOLUS_VARIANTS][MARGOLUS_COMBINATIONS];
+};
+
+// 第一次调用时生成，之后只读
+const MargolusRules& margolus_rules();
+
+MargolusClass margolus_class(MaterialPhase phase);
+
+static inline uint32_t margolus_index(uint8_t tl, uint8_t tr, uint8_t bl, uint8_t br)
+{
+    return tl + MARGOLUS_CLASS_COUNT * (tr + MARGOLUS_CLASS_COUNT * (bl + MARGOLUS_CLASS_COUNT * br));
+}
+
+// 轻重次序：气体 < 空格 < 液体 < 粉末。重的下沉，轻的上浮；固体不参与
+static inline bool margolus_sinks(uint8_t upper, uint8_t lower)
+{
+    static const int8_t weight[MARGOLUS_CLASS_COUNT] = { 1, 0, 2, 3, 0 };
+    return upper != MARGOLUS_SOLID && lower != MARGOLUS_SOLID && weight[upper] > weight[lower];
+}
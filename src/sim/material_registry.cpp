@@ -0,0 +1,244 @@
+#include "material_registry.h"
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <spdlog/spdlog.h>
+
+#include "Utilities.h"
+
+static const char* k_phase_names[] = { "empty", "solid", "powder", "liquid", "gas" };
+
+static const char* k_update_names[UPDATE_KERNEL_COUNT] = {
+    "none", "sand", "water", "salt", "fire", "lava", "smoke",
+    "ember", "steam", "gunpowder", "oil", "acid", "default",
+    "static", "powder", "liquid", "gas"
+};
+
+template <typename T, size_t N>
+static bool parse_enum(const std::string& value, const char* const (&names)[N], T& out)
+{
+    for (size_t i = 0; i < N; ++i) {
+        if (value == names[i]) {
+            out = (T)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parse_color(std::istringstream& in, Color& out)
+{
+    int r, g, b, a;
+    if (!(in >> r >> g >> b >> a)) return false;
+    out = Color{(uint8_t)utilities_clamp(r, 0, 255), (uint8_t)utilities_clamp(g, 0, 255),
+                (uint8_t)utilities_clamp(b, 0, 255), (uint8_t)utilities_clamp(a, 0, 255)};
+    return true;
+}
+
+MaterialRegistry::MaterialRegistry() {
+    load_defaults();
+    compile();
+}
+
+void MaterialRegistry::load_defaults() {
+    auto define = [this](uint8_t id, const char* name, MaterialPhase phase, MaterialUpdate update,
+                         float density, float flammability, float life_min, float life_max,
+                         uint8_t variations, Color from, Color to) {
+        MaterialDef& d = m_defs[id];
+        d.name = name;
+        d.defined = true;
+        d.phase = phase;
+        d.update = update;
+        d.density = density;
+        d.flammability = flammability;
+        d.lifetime_min = life_min;
+        d.lifetime_max = life_max;
+        d.variations = variations;
+        d.color_from = from;
+        d.color_to = to;
+    };
+
+    // 与 assets/materials/materials.txt 保持一致，文件缺失时使用
+    define(mat_id_empty, "empty", PHASE_EMPTY, UPDATE_NONE, 0.f, 0.f, 0.f, 0.f, 1, mat_col_empty, mat_col_empty);
+    define(mat_id_sand, "sand", PHASE_POWDER, UPDATE_SAND, 1.6f, 0.f, 0.f, 0.f, 11, (Color){204, 127, 51, 255}, (Color){255, 153, 63, 255});
+    define(mat_id_water, "water", PHASE_LIQUID, UPDATE_WATER, 1.0f, 0.f, 0.f, 0.f, 2, (Color){25, 76, 178, 255}, (Color){31, 82, 191, 255});
+    define(mat_id_salt, "salt", PHASE_POWDER, UPDATE_SALT, 2.1f, 0.f, 0.f, 0.f, 2, (Color){229, 204, 204, 255}, (Color){242, 210, 216, 255});
+    define(mat_id_wood, "wood", PHASE_SOLID, UPDATE_STATIC, 0.7f, 0.5f, 0.f, 0.f, 2, (Color){58, 38, 5, 255}, (Color){61, 42, 6, 255});
+    define(mat_id_fire, "fire", PHASE_GAS, UPDATE_FIRE, 0.001f, 0.f, 0.2f, 0.6f, 1, mat_col_fire, mat_col_fire);
+    define(mat_id_smoke, "smoke", PHASE_GAS, UPDATE_SMOKE, 0.001f, 0.f, 1.0f, 3.0f, 1, mat_col_smoke, mat_col_smoke);
+    define(mat_id_ember, "ember", PHASE_POWDER, UPDATE_EMBER, 0.5f, 0.f, 0.5f, 1.5f, 1, mat_col_ember, mat_col_ember);
+    define(mat_id_steam, "steam", PHASE_GAS, UPDATE_STEAM, 0.0006f, 0.f, 1.0f, 3.0f, 1, mat_col_steam, mat_col_steam);
+    define(mat_id_gunpowder, "gunpowder", PHASE_POWDER, UPDATE_GUNPOWDER, 1.7f, 1.0f, 0.f, 0.f, 2, (Color){38, 38, 38, 255}, (Color){44, 44, 44, 255});
+    define(mat_id_oil, "oil", PHASE_LIQUID, UPDATE_OIL, 0.9f, 0.8f, 0.f, 0.f, 2, (Color){30, 25, 20, 255}, (Color){34, 28, 22, 255});
+    define(mat_id_lava, "lava", PHASE_LIQUID, UPDATE_LAVA, 3.1f, 0.f, 0.f, 0.f, 1, mat_col_fire, mat_col_fire);
+    define(mat_id_stone, "stone", PHASE_SOLID, UPDATE_STATIC, 2.6f, 0.f, 0.f, 0.f, 2, (Color){127, 127, 127, 255}, (Color){146, 146, 146, 255});
+    define(mat_id_acid, "acid", PHASE_LIQUID, UPDATE_ACID, 1.05f, 0.f, 0.f, 0.f, 2, (Color){12, 204, 25, 200}, (Color){14, 210, 28, 200});
+    // 网格边框的幽灵格，保留 id，材质文件不能使用
+    define(mat_id_ghost, "ghost", PHASE_SOLID, UPDATE_NONE, 0.f, 0.f, 0.f, 0.f, 1, mat_col_empty, mat_col_empty);
+
+    m_defs[mat_id_fire].temperature = 800.f;
+    m_defs[mat_id_smoke].temperature = 150.f;
+    m_defs[mat_id_ember].temperature = 600.f;
+    m_defs[mat_id_steam].temperature = 100.f;
+    m_defs[mat_id_lava].temperature = 1200.f;
+}
+
+bool MaterialRegistry::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        spdlog::warn("Material file not found: {}, using built-in materials", path);
+        return false;
+    }
+
+    // 先解析到副本中，文件有错误时不影响当前定义
+    MaterialDef defs[MATERIAL_MAX_COUNT];
+    for (int32_t i = 0; i < MATERIAL_MAX_COUNT; ++i) defs[i] = m_defs[i];
+
+    MaterialDef current;
+    int32_t current_id = -1;
+    bool in_section = false;
+    bool ok = true;
+
+    auto flush = [&]() {
+        if (!in_section) return;
+        if (current_id < 0) {
+            // 新材质分配下一个空闲 id
+            for (int32_t i = 0; i < MATERIAL_MAX_COUNT && current_id < 0; ++i) {
+                if (!defs[i].defined) current_id = i;
+            }
+        }
+        if (current_id < 0) {
+            spdlog::error("{}: no free material id for [{}]", path, current.name);
+            ok = false;
+            return;
+        }
+        current.defined = true;
+        defs[current_id] = current;
+    };
+
+    std::string line;
+    int32_t line_number = 0;
+    while (std::getline(file, line)) {
+        ++line_number;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+
+        size_t begin = line.find_first_not_of(" \t\r");
+        if (begin == std::string::npos) continue;
+        size_t end = line.find_last_not_of(" \t\r");
+        line = line.substr(begin, end - begin + 1);
+
+        if (line.front() == '[' && line.back() == ']') {
+            flush();
+            current = MaterialDef{};
+            current.name = line.substr(1, line.size() - 2);
+            current_id = -1;
+            in_section = true;
+            // 已有同名材质时在原定义基础上修改
+            for (int32_t i = 0; i < MATERIAL_MAX_COUNT; ++i) {
+                if (defs[i].defined && defs[i].name == current.name && i != mat_id_ghost) {
+                    current = defs[i];
+                    current_id = i;
+                    break;
+                }
+            }
+            continue;
+        }
+
+        size_t eq = line.find('=');
+        if (!in_section || eq == std::string::npos) {
+            spdlog::error("{}:{}: unexpected line '{}'", path, line_number, line);
+            ok = false;
+            continue;
+        }
+
+        std::string key = line.substr(0, line.find_last_not_of(" \t", eq - 1) + 1);
+        std::istringstream value(line.substr(eq + 1));
+        std::string word;
+        bool parsed = true;
+
+        if (key == "id") {
+            int32_t id;
+            parsed = (bool)(value >> id) && id >= 0 && id < MATERIAL_MAX_COUNT && id != mat_id_ghost;
+            if (parsed) current_id = id;
+        } else if (key == "phase") {
+            parsed = (bool)(value >> word) && parse_enum(word, k_phase_names, current.phase);
+        } else if (key == "update") {
+            parsed = (bool)(value >> word) && parse_enum(word, k_update_names, current.update);
+        } else if (key == "density") {
+            parsed = (bool)(value >> current.density);
+        } else if (key == "flammability") {
+            parsed = (bool)(value >> current.flammability);
+        } else if (key == "temperature") {
+            parsed = (bool)(value >> current.temperature);
+        } else if (key == "lifetime") {
+            parsed = (bool)(value >> current.lifetime_min >> current.lifetime_max);
+        } else if (key == "variations") {
+            int32_t n;
+            parsed = (bool)(value >> n) && n >= 1 && n <= MATERIAL_MAX_VARIATIONS;
+            if (parsed) current.variations = (uint8_t)n;
+        } else if (key == "color") {
+            parsed = parse_color(value, current.color_from);
+            current.color_to = current.color_from;
+        } else if (key == "color_to") {
+            parsed = parse_color(value, current.color_to);
+        } else {
+            spdlog::warn("{}:{}: unknown key '{}'", path, line_number, key);
+        }
+
+        if (!parsed) {
+            spdlog::error("{}:{}: invalid value for '{}'", path, line_number, key);
+            ok = false;
+        }
+    }
+    flush();
+
+    if (!ok) {
+        spdlog::error("Failed to load material file: {}", path);
+        return false;
+    }
+
+    for (int32_t i = 0; i < MATERIAL_MAX_COUNT; ++i) m_defs[i] = defs[i];
+    compile();
+    return true;
+}
+
+int32_t MaterialRegistry::find(const std::string& name) const {
+    for (int32_t i = 0; i < MATERIAL_MAX_COUNT; ++i) {
+        if (m_defs[i].defined && m_defs[i].name == name) return i;
+    }
+    return -1;
+}
+
+void MaterialRegistry::compile() {
+    memset(&m_table, 0, sizeof(m_table));
+
+    for (int32_t id = 0; id < MATERIAL_MAX_COUNT; ++id) {
+        const MaterialDef& d = m_defs[id];
+        if (!d.defined) {
+            // 未定义的 id 视为不更新的固体，避免越界材质被当作空格子
+            m_table.phase[id] = PHASE_SOLID;
+            m_table.update[id] = UPDATE_NONE;
+            m_table.variation_count[id] = 1;
+            continue;
+        }
+
+        m_table.density[id] = d.density;
+        m_table.flammability[id] = d.flammability;
+        m_table.lifetime_min[id] = d.lifetime_min;
+        m_table.lifetime_max[id] = d.lifetime_max;
+        m_table.phase[id] = d.phase;
+        m_table.update[id] = d.update;
+        m_table.variation_count[id] = d.variations;
+
+        // 预先计算颜色渐变，生成粒子时只需随机选一档
+        for (uint32_t v = 0; v < d.variations; ++v) {
+            float t = d.variations > 1 ? (float)v / (float)(d.variations - 1) : 0.f;
+            Color& c = m_table.colors[id][v];
+            c.r = (uint8_t)Utilities::interp_linear(d.color_from.r, d.color_to.r, t);
+            c.g = (uint8_t)Utilities::interp_linear(d.color_from.g, d.color_to.g, t);
+            c.b = (uint8_t)Utilities::interp_linear(d.color_from.b, d.color_to.b, t);
+            c.a = (uint8_t)Utilities::interp_linear(d.color_from.a, d.color_to.a, t);
+        }
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+
+#include "ParticleSim.h"
+
+#define MATERIAL_MAX_COUNT 256
+#define MATERIAL_MAX_VARIATIONS 16
+
+// 材质使用的更新函数，ParticleSimulator 据此构建分派表
+enum MaterialUpdate : uint8_t {
+    UPDATE_NONE = 0,
+    UPDATE_SAND,
+    UPDATE_WATER,
+    UPDATE_SALT,
+    UPDATE_FIRE,
+    UPDATE_LAVA,
+    UPDATE_SMOKE,
+    UPDATE_EMBER,
+    UPDATE_STEAM,
+    UPDATE_GUNPOWDER,
+    UPDATE_OIL,
+    UPDATE_ACID,
+    UPDATE_DEFAULT,
+    // 没有专用特征的材质使用通用的运动原型
+    UPDATE_STATIC,
+    UPDATE_POWDER,
+    UPDATE_LIQUID,
+    UPDATE_GAS,
+    UPDATE_KERNEL_COUNT
+};
+
+// 编译后的材质属性表，按 id 索引的扁平数组，每个数组按缓存行对齐
+struct MaterialTable {
+    alignas(64) float density[MATERIAL_MAX_COUNT];
+    alignas(64) float flammability[MATERIAL_MAX_COUNT];
+    alignas(64) float lifetime_min[MATERIAL_MAX_COUNT];
+    alignas(64) float lifetime_max[MATERIAL_MAX_COUNT];
+    alignas(64) uint8_t phase[MATERIAL_MAX_COUNT];
+    alignas(64) uint8_t update[MATERIAL_MAX_COUNT];
+    alignas(64) uint8_t variation_count[MATERIAL_MAX_COUNT];
+    alignas(64) Color colors[MATERIAL_MAX_COUNT][MATERIAL_MAX_VARIATIONS];
+};
+
+// 一条材质定义，对应材质文件中的一个 [name] 段
+struct MaterialDef {
+    std::string name;
+    bool defined = false;
+    MaterialPhase phase = PHASE_EMPTY;
+    MaterialUpdate update = UPDATE_NONE;
+    float density = 0.f;        // 粉末和液体沉入比自己轻的液体
+    float flammability = 0.f;   // 0-1，供燃烧规则使用，目前的移动规则不读取
+    float lifetime_min = 0.f;
+    float lifetime_max = 0.f;
+    float temperature = 20.f;   // 摄氏度，只用于热度调色板
+    uint8_t variations = 1;
+    Color color_from = {0, 0, 0, 0};
+    Color color_to = {0, 0, 0, 0};
+};
+
+// 材质注册表：内置 mat_id_* 对应的默认定义，启动时可由文本文件覆盖或追加。
+// 文件格式为 INI 风格，每个材质一段：
+//
+//   [sand]
+//   id = 1              # 省略时分配下一个空闲 id
+//   phase = powder      # empty / solid / powder / liquid / gas
+//   update = sand       # 更新函数，见 MaterialUpdate
+//   density = 1.6
+//   flammability = 0
+//   lifetime = 0 0      # 生成时在 [min, max] 内随机
+//   temperature = 20    # 摄氏度，热度视图的配色依据
+//   variations = 11     # 颜色渐变的档数，最多 MATERIAL_MAX_VARIATIONS
+//   color = 204 127 51 255
+//   color_to = 255 153 63 255
+class MaterialRegistry {
+public:
+    MaterialRegistry();
+
+    // 加载材质文件，失败时保留当前定义并返回 false
+    bool load(const std::string& path);
+
+    // 根据名字查找 id，找不到返回 -1
+    int32_t find(const std::string& name) const;
+
+    const MaterialDef& def(uint8_t id) const { return m_defs[id]; }
+    const MaterialTable& table() const { return m_table; }
+
+private:
+    void load_defaults();
+    void compile();
+
+    MaterialDef m_defs[MATERIAL_MAX_COUNT];
+    MaterialTable m_table;
+};
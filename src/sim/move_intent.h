@@ -0,0 +1,88 @@
+#pragma once
+// 两阶段的移动意图引擎。
+// 第一遍每个醒着的区块只读网格，为可动的格子各求一个目标并发出意图，意图用 key 以原子取最大的方式
+// 同时认领出发格和目标格；第二遍只执行同时拿到两格的意图，它们两两不相交，可以任意顺序并行写入。
+// 结果只由世界种子、帧号和区块位置决定，与线程数和扫描顺序无关。只应被 ParticleSim.cpp 包含。
+#include "ParticleSim.h"
+#include "Utilities.h"
+#include "margolus.h"
+
+static inline void claim_cell(std::atomic<uint64_t>& claim, uint64_t key)
+{
+    uint64_t cur = claim.load(std::memory_order_relaxed);
+    while (key > cur && !claim.compare_exchange_weak(cur, key, std::memory_order_relaxed)) {}
+}
+
+// 与 Margolus 规则相同的运动：先竖直，再按随机顺序试两个斜向，液体和气体最后试两侧的空格。
+// 粉末、液体向下沉入更轻的格子，气体向上与更重的格子交换；幽灵格是固体，不需要边界检查
+inline int32_t ParticleSimulator::find_move_target(int32_t idx, uint8_t cls, uint64_t random)
+{
+    bool rising = cls == MARGOLUS_GAS;
+    NeighborDir ahead = rising ? NEIGHBOR_UP : NEIGHBOR_DOWN;
+    NeighborDir right = rising ? NEIGHBOR_UP_RIGHT : NEIGHBOR_DOWN_RIGHT;
+    NeighborDir left = rising ? NEIGHBOR_UP_LEFT : NEIGHBOR_DOWN_LEFT;
+    bool right_first = random & 1;
+    const int32_t candidates[3] = { idx + m_neighbor_offset[ahead], idx + m_neighbor_offset[right_first ? right : left],
+                                    idx + m_neighbor_offset[right_first ? left : right] };
+    for (int32_t target : candidates) {
+        uint8_t other = m_margolus_class[m_grid.id[target]];
+        if (rising ? margolus_sinks(other, cls) : margolus_sinks(cls, other)) return target;
+    }
+    if (cls == MARGOLUS_POWDER) return -1;
+
+    int32_t side = m_neighbor_offset[(random & 2) ? NEIGHBOR_RIGHT : NEIGHBOR_LEFT];
+    if (m_grid.id[idx + side] == mat_id_empty) return idx + side;
+    if (m_grid.id[idx - side] == mat_id_empty) return idx - side;
+    return -1;
+}
+
+inline void ParticleSimulator::emit_chunk_intents(int32_t cx, int32_t cy)
+{
+    SimChunk& c = m_chunks[cy * m_chunkCountX + cx];
+    if (!c.is_awake(m_chunk_sleep_frames) || c.min_x > c.max_x) return;
+
+    for (int32_t y = c.min_y; y <= c.max_y; ++y) {
+        int32_t row = compute_idx(0, y);
+        for (int32_t x = c.min_x; x <= c.max_x; ++x) {
+            int32_t idx = row + x;
+            uint8_t cls = m_margolus_class[m_grid.id[idx]];
+            if (cls == MARGOLUS_EMPTY || cls == MARGOLUS_SOLID) continue;
+
+            uint64_t random = Utilities::random_bits64();
+            int32_t target = find_move_target(idx, cls, random);
+            if (target < 0) continue;
+
+            uint64_t key = (random & 0xFFFFFFFF00000000ull) | (uint32_t)idx;
+            claim_cell(m_move_claims[idx], key);
+            claim_cell(m_move_claims[target], key);
+            c.intents.push_back(MoveIntent { idx, target, key });
+        }
+    }
+}
+
+inline void ParticleSimulator::apply_chunk_intents(int32_t cx, int32_t cy)
+{
+    for (const MoveIntent& m : m_chunks[cy * m_chunkCountX + cx].intents) {
+        if (m_move_claims[m.from].load(std::memory_order_relaxed) == m.key &&
+            m_move_claims[m.to].load(std::memory_order_relaxed) == m.key) {
+            Particle a = m_grid.get(m.from);
+            Particle b = m_grid.get(m.to);
+            write_data(m.to, a);
+            write_data(m.from, b);
+        } else {
+            // 输掉的格子下一个 tick 再试
+            mark_dirty(m.from % m_stride - SIM_GRID_PADDING, m.from / m_stride - SIM_GRID_PADDING);
+        }
+    }
+}
+
+// 在下一个 tick 开始时清除上一个 tick 的认领，此时所有区块都已执行完
+inline void ParticleSimulator::release_chunk_claims(int32_t cx, int32_t cy)
+{
+    SimChunk& c = m_chunks[cy * m_chunkCountX + cx];
+    for (const MoveIntent& m : c.intents) {
+        m_move_claims[m.from].store(0, std::memory_order_relaxed);
+        m_move_claims[m.to].store(0, std::memory_order_relaxed);
+    }
+    c.intents.clear();
+}
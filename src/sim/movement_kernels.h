@@ -0,0 +1,271 @@
+#pragma once
+// 按运动原型（粉末/液体/气体）和材质特征在编译期生成的更新函数。
+// 特征里的常量（重力方向、扩散距离、可置换材质集合）在实例化时折叠，
+// update_sand 等函数只是对应实例的包装。只应被 ParticleSim.cpp 包含。
+#include <cfloat>
+#include <cmath>
+#include <initializer_list>
+
+#include "ParticleSim.h"
+#include "Utilities.h"
+
+// 由 id 列表组成的材质集合
+constexpr MaterialMask mat_mask(std::initializer_list<uint8_t> ids)
+{
+    MaterialMask mask;
+    for (uint8_t id : ids) mask.set(id);
+    return mask;
+}
+
+constexpr MaterialMask k_mask_empty = mat_mask({ mat_id_empty });
+
+// 材质特征的默认值，具体材质只覆盖不同的部分。
+// 可以置换哪些材质不在特征里，由 build_update_table 按材质表的相态和密度生成 m_displace_table
+struct PowderTraits {
+    static constexpr int32_t gravity_sign = 1;      // 1 向下，-1 向上
+    static constexpr int32_t dispersion = 0;        // 每帧最多水平移动的格数：液体在此范围内找落点，气体随机扩散
+    static constexpr float max_speed = 20.f;        // 速度上限（格/帧），不超过 SIM_MAX_REACH
+    static constexpr bool decays = false;           // 是否按 lifetime 消失
+};
+
+struct LiquidTraits {
+    static constexpr int32_t gravity_sign = 1;
+    static constexpr int32_t dispersion = 16;
+    static constexpr float max_speed = 20.f;
+    static constexpr bool decays = false;
+};
+
+struct GasTraits {
+    static constexpr int32_t gravity_sign = -1;
+    static constexpr int32_t dispersion = 2;
+    static constexpr float max_speed = 4.f;
+    static constexpr bool decays = true;
+};
+
+struct SandTraits : PowderTraits {};
+struct SaltTraits : PowderTraits {};
+struct GunpowderTraits : PowderTraits {};
+struct EmberTraits : PowderTraits {
+    static constexpr bool decays = true;
+};
+
+struct WaterTraits : LiquidTraits {
+    static constexpr int32_t dispersion = 24;
+};
+struct OilTraits : LiquidTraits {};
+struct AcidTraits : LiquidTraits {};
+struct LavaTraits : LiquidTraits {
+    static constexpr int32_t dispersion = 4;
+    static constexpr float max_speed = 4.f;
+};
+
+struct FireTraits : GasTraits {
+    static constexpr int32_t dispersion = 1;
+};
+struct SmokeTraits : GasTraits {};
+struct SteamTraits : GasTraits {
+    static constexpr int32_t dispersion = 3;
+};
+
+// 重力积分在移动之前对整个脏矩形统一进行（integrate_chunk），参数由 build_update_table 按更新函数填入按 id 索引的表。
+// 不受重力的材质上限为 FLT_MAX，积分时速度不变
+struct MovementParams {
+    float gravity_sign;
+    float max_speed;
+    bool bitboard;  // 规则与默认粉末完全相同，可以走 update_chunk_bitboard
+    bool column_run;    // 向下运动且不衰变，自由下落的竖直连续段可以整段平移（update_column_run）
+    bool decays;        // 按 lifetime 消失，块引擎在运动之后由 decay_chunk 处理
+};
+
+template <typename T>
+constexpr MovementParams movement_params()
+{
+    constexpr bool plain_powder = T::gravity_sign == PowderTraits::gravity_sign && T::dispersion == 0 &&
+                                  !T::decays;
+    return MovementParams { (float)T::gravity_sign, T::max_speed, plain_powder, T::gravity_sign > 0 && !T::decays,
+                            T::decays };
+}
+
+// 液体寻找落点时沿所在行搜索的距离，读取范围不超过 SIM_MAX_REACH
+constexpr int32_t k_liquid_search = SIM_MAX_REACH - 1;
+
+constexpr MovementParams k_static_movement = { 0.f, FLT_MAX, false, false, false };
+
+// 边框是幽灵格（不在任何置换集合内），不需要边界判断
+inline bool ParticleSimulator::can_displace(uint8_t mover, int32_t idx)
+{
+    return m_displace_table[mover].test(m_grid.id[idx]);
+}
+
+// 从 idx 沿位移 (dx, dy) 的 Bresenham 直线逐格前进，遇到第一个 id 不在 passable 内的格子就停下，
+// 返回最后一个可通过格子的下标，第一格就被挡住时返回 idx。路径上的格子都检查过，快速粒子不会穿过薄墙；
+// 斜走一步时两个正交相邻格至少有一个可通过，不会从两个对角相接的格子之间的缝里漏过去。
+// 只读 id 平面；位移不超过 SIM_MAX_REACH，幽灵格不可通过，不需要边界判断
+inline int32_t ParticleSimulator::trace_path(int32_t idx, int32_t dx, int32_t dy, const MaterialMask& passable)
+{
+    int32_t major = std::abs(dx);
+    int32_t minor = std::abs(dy);
+    int32_t major_step = m_neighbor_offset[dx > 0 ? NEIGHBOR_RIGHT : NEIGHBOR_LEFT];
+    int32_t minor_step = m_neighbor_offset[dy > 0 ? NEIGHBOR_DOWN : NEIGHBOR_UP];
+    if (minor > major) {
+        std::swap(major, minor);
+        std::swap(major_step, minor_step);
+    }
+
+    int32_t cur = idx;
+    int32_t err = major / 2;
+    for (int32_t i = 0; i < major; ++i) {
+        int32_t next = cur + major_step;
+        err -= minor;
+        if (err < 0) {
+            if (!passable.test(m_grid.id[next]) && !passable.test(m_grid.id[cur + minor_step])) break;
+            next += minor_step;
+            err += major;
+        }
+        if (!passable.test(m_grid.id[next])) break;
+        cur = next;
+    }
+    return cur;
+}
+
+inline void ParticleSimulator::move_to(int32_t idx, int32_t target)
+{
+    Particle a = m_grid.get(idx);
+    Particle b = m_grid.get(target);
+    write_data(target, a);
+    write_data(idx, b);
+}
+
+template <MovementArchetype A, typename T>
+void ParticleSimulator::update_movement(uint32_t ux, uint32_t uy)
+{
+    static_assert(A != ARCHETYPE_STATIC, "static materials have no update");
+    static_assert(T::dispersion + 1 <= SIM_MAX_REACH && T::max_speed + 1 <= SIM_MAX_REACH,
+                  "kernel reach exceeds SIM_MAX_REACH");
+    static_assert(T::max_speed + 1 <= SIM_GRID_PADDING, "kernel reach exceeds the ghost border");
+    static_assert(A != ARCHETYPE_LIQUID || T::dispersion <= k_liquid_search, "liquid dispersion exceeds the search span");
+    constexpr int32_t dir = T::gravity_sign;
+    constexpr NeighborDir forward = dir > 0 ? NEIGHBOR_DOWN : NEIGHBOR_UP;
+
+    int32_t x = (int32_t)ux;
+    int32_t y = (int32_t)uy;
+    int32_t idx = compute_idx(x, y);
+    uint8_t id = m_grid.id[idx];
+
+    // lifetime 为 0 的粒子不会消失
+    if constexpr (T::decays) {
+        float& lifetime = m_grid.lifetime[idx];
+        if (lifetime > 0.f) {
+            lifetime -= m_deltaTime;
+            if (lifetime <= 0.f) {
+                write_data(idx, particle_empty());
+                return;
+            }
+            // 寿命还在流逝，保持区块唤醒
+            mark_dirty(x, y);
+        }
+    }
+
+    // 被托住的液体离开后，空出的格子可能成为上一行远处液体的落点，或让同一行的可通过段变长，按搜索距离唤醒。
+    // 自由下落的液体不需要：它上方的同伴会自己跟着落下
+    auto move = [&](int32_t target) {
+        move_to(idx, target);
+        if constexpr (A == ARCHETYPE_LIQUID) mark_dirty_span(x - k_liquid_search, x + k_liquid_search, y - 1);
+    };
+
+    // 速度已由本帧开始时的重力积分更新，这里只负责位移
+    Vec2& velocity = m_grid.velocity[idx];
+
+    // 1. 沿速度方向逐格前进，停在第一个挡路的格子之前；速度足够时一次跨多格，亚格位移累积在格子的余量里。
+    //    重力方向至少走一格，水平速度同样不超过速度上限。没有走完全程（被挡住或被限速）时余量清零
+    uint8_t frac_x = m_grid.frac_x[idx];
+    uint8_t frac_y = m_grid.frac_y[idx];
+    int32_t fall = fixed_fall(fixed_from_float(std::fabs(velocity.y)), frac_y);
+    int32_t drift = fixed_advance(fixed_from_float(velocity.x), frac_x);
+    if (std::abs(drift) > (int32_t)T::max_speed) {
+        drift = std::clamp(drift, -(int32_t)T::max_speed, (int32_t)T::max_speed);
+        frac_x = 0;
+    }
+    const MaterialMask& passable = m_displace_table[id];
+    int32_t target = trace_path(idx, drift, dir * fall, passable);
+    bool arrived = target == idx + drift + dir * fall * m_stride;
+    m_grid.frac_x[idx] = arrived ? frac_x : 0;
+    m_grid.frac_y[idx] = arrived ? frac_y : 0;
+    if (target != idx) {
+        move_to(idx, target);
+        return;
+    }
+
+    // 被挡住，速度减半
+    velocity.y *= 0.5f;
+
+    // 2. 斜向滑落，随机选择先尝试哪一侧
+    int32_t side = Utilities::random_val(0, 1) ? 1 : -1;
+    for (int32_t pass = 0; pass < 2; ++pass, side = -side) {
+        target = trace_path(idx, side, dir, passable);
+        if (target != idx) {
+            move(target);
+            return;
+        }
+    }
+
+    // 3. 液体沿所在行的连续可通过段寻找最近的落点（下一行可通过的格子）。落点在 dispersion 以内时
+    //    一步移到落点下方，更远时沿可通过段朝它移动 dispersion 格，不超出可通过段。搜索范围内没有落点时，
+    //    按帧开始时整行求出的落点方向（OccupancyBitmap::update_drain_row）朝连通段里最近的落点移动，
+    //    液面上多出的格子会一路走到液面较低的一端。连通段内没有落点时不动，液面平了（最多差一行）以后区块休眠
+    if constexpr (A == ARCHETYPE_LIQUID) {
+        int32_t runs[2] = {};
+        int32_t best = -1;
+        int32_t best_distance = INT32_MAX;
+        int32_t best_run = 0;
+        for (int32_t pass = 0; pass < 2; ++pass, side = -side) {
+            int32_t reach = m_occupancy.free_run(x, y, side, k_liquid_search, true);
+            runs[pass] = reach;
+            if (reach < 2) continue;
+            int32_t lo = side > 0 ? x + 2 : x - reach;
+            int32_t hi = side > 0 ? x + reach : x - 2;
+            int32_t drop = m_occupancy.nearest_free_in_row(x, y + dir, lo, hi, true);
+            if (drop >= 0 && std::abs(drop - x) < best_distance) {
+                best = drop;
+                best_distance = std::abs(drop - x);
+                best_run = reach;
+            }
+        }
+        // 所有多格移动都逐格检查路径：到落点先沿本行走完，再向下进入落点，不斜穿下一行被占的格子
+        if (best >= 0) {
+            if (best_distance <= T::dispersion) {
+                target = trace_path(idx, best - x, 0, passable);
+                if (target == idx + (best - x) && can_displace(id, target + m_neighbor_offset[forward])) {
+                    move(target + m_neighbor_offset[forward]);
+                    return;
+                }
+            } else {
+                target = trace_path(idx, (best > x ? 1 : -1) * std::min(T::dispersion, best_run), 0, passable);
+            }
+            if (target != idx) move(target);
+            return;
+        }
+        // 前方紧挨着同伴时等它先走
+        int32_t drain = m_occupancy.drain_side(x, y);
+        int32_t drain_run = drain == side ? runs[0] : runs[1];
+        if (drain != 0 && drain_run > 0) {
+            target = trace_path(idx, drain * std::min(T::dispersion, drain_run), 0, passable);
+            if (target != idx) move(target);
+        }
+        return;
+    }
+
+    // 4. 气体沿水平方向随机扩散，用占用位图一次求出可移动的距离，只能进入空格
+    if constexpr (T::dispersion > 0) {
+        for (int32_t pass = 0; pass < 2; ++pass, side = -side) {
+            int32_t reach = m_occupancy.free_run(x, y, side, T::dispersion, false);
+            if (reach > 0) {
+                target = trace_path(idx, side * reach, 0, passable);
+                if (target != idx) {
+                    move(target);
+                    return;
+                }
+            }
+        }
+    }
+}
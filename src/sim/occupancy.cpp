@@ -0,0 +1,198 @@
+#include "occupancy.h"
+#include <algorithm>
+#include <bit>
+
+#include "simd.h"
+
+void OccupancyBitmap::resize(int32_t width, int32_t height) {
+    m_width = width;
+    m_height = height;
+    m_wordsPerRow = (width + 63) / 64;
+    m_occupied.assign((size_t)m_wordsPerRow * height, 0);
+    m_liquid.assign((size_t)m_wordsPerRow * height, 0);
+    m_gas.assign((size_t)m_wordsPerRow * height, 0);
+    m_drain_left.assign((size_t)m_wordsPerRow * height, 0);
+    m_drain_right.assign((size_t)m_wordsPerRow * height, 0);
+    clear();
+}
+
+void OccupancyBitmap::clear() {
+    const SimKernels& kernels = simd_kernels();
+    int32_t bytes = (int32_t)(m_occupied.size() * sizeof(uint64_t));
+    kernels.clear_bytes((uint8_t*)m_occupied.data(), bytes);
+    kernels.clear_bytes((uint8_t*)m_liquid.data(), bytes);
+    kernels.clear_bytes((uint8_t*)m_gas.data(), bytes);
+    kernels.clear_bytes((uint8_t*)m_drain_left.data(), bytes);
+    kernels.clear_bytes((uint8_t*)m_drain_right.data(), bytes);
+
+    // 行尾超出宽度的位标记为占用，查询时不需要再判断右边界
+    if (m_width & 63) {
+        uint64_t tail = ~0ull << (m_width & 63);
+        for (int32_t y = 0; y < m_height; ++y) {
+            m_occupied[(size_t)y * m_wordsPerRow + m_wordsPerRow - 1] = tail;
+        }
+    }
+}
+
+int32_t OccupancyBitmap::count_free(int32_t y, int32_t x0, int32_t x1, bool gas_is_free) const {
+    if (y < 0 || y >= m_height) return 0;
+    x0 = std::max(x0, 0);
+    x1 = std::min(x1, m_width - 1);
+    if (x0 > x1) return 0;
+
+    size_t first = (size_t)y * m_wordsPerRow + (x0 >> 6);
+    return simd_kernels().count_free_span(&m_occupied[first], gas_is_free ? &m_gas[first] : nullptr,
+                                          (x1 >> 6) - (x0 >> 6) + 1, span_mask(x0, 63), span_mask(0, x1));
+}
+
+int32_t OccupancyBitmap::find_free(int32_t y, int32_t x0, int32_t x1, bool gas_is_free, bool reverse) const {
+    size_t first = (size_t)y * m_wordsPerRow + (x0 >> 6);
+    int32_t bit = simd_kernels().find_free_span(&m_occupied[first], gas_is_free ? &m_gas[first] : nullptr,
+                                                (x1 >> 6) - (x0 >> 6) + 1, span_mask(x0, 63), span_mask(0, x1), reverse);
+    return bit < 0 ? -1 : (x0 & ~63) + bit;
+}
+
+int32_t OccupancyBitmap::free_run(int32_t x, int32_t y, int32_t dir, int32_t max_len, bool gas_is_free) const {
+    if (y < 0 || y >= m_height || max_len <= 0) return 0;
+
+    int32_t run = 0;
+    if (dir > 0) {
+        int32_t pos = x + 1;
+        int32_t end = std::min(x + max_len, m_width - 1);
+        while (pos <= end) {
+            // 从 pos 开始数连续的 1
+            uint64_t bits = free_word(y, pos >> 6, gas_is_free) >> (pos & 63);
+            int32_t avail = 64 - (pos & 63);
+            int32_t ones = std::min(std::countr_one(bits), avail);
+            run += ones;
+            if (ones < avail) break;
+            pos += ones;
+        }
+        return std::min(run, std::max(end - x, 0));
+    } else {
+        int32_t pos = x - 1;
+        int32_t end = std::max(x - max_len, 0);
+        while (pos >= end) {
+            // 从 pos 开始向低位数连续的 1
+            uint64_t bits = free_word(y, pos >> 6, gas_is_free) << (63 - (pos & 63));
+            int32_t avail = (pos & 63) + 1;
+            int32_t ones = std::min(std::countl_one(bits), avail);
+            run += ones;
+            if (ones < avail) break;
+            pos -= ones;
+        }
+        return std::min(run, std::max(x - end, 0));
+    }
+}
+
+int32_t OccupancyBitmap::nearest_free_in_row(int32_t x, int32_t y, int32_t x0, int32_t x1, bool gas_is_free) const {
+    if (y < 0 || y >= m_height) return -1;
+    x0 = std::max(x0, 0);
+    x1 = std::min(x1, m_width - 1);
+    if (x0 > x1) return -1;
+    x = std::clamp(x, x0, x1);
+
+    // 向右：[x, x1] 内第一个可通过位；向左：[left_limit, x] 内最后一个，只需要搜到比 right 更近的范围
+    int32_t right = find_free(y, x, x1, gas_is_free, false);
+    int32_t left_limit = right >= 0 ? std::max(x0, x - (right - x)) : x0;
+    int32_t left = find_free(y, left_limit, x, gas_is_free, true);
+
+    if (left < 0) return right;
+    if (right < 0) return left;
+    return (x - left) < (right - x) ? left : right;
+}
+
+bool OccupancyBitmap::find_nearest_free(int32_t x, int32_t y, int32_t x0, int32_t y0, int32_t x1, int32_t y1,
+                                        bool gas_is_free, int32_t* out_x, int32_t* out_y) const {
+    y0 = std::max(y0, 0);
+    y1 = std::min(y1, m_height - 1);
+
+    int64_t best = INT64_MAX;
+    int32_t max_dy = std::max(y - y0, y1 - y);
+    for (int32_t dy = 0; dy <= max_dy && (int64_t)dy * dy < best; ++dy) {
+        // 同一距离先查上方一行，保证结果确定
+        int32_t rows[2] = { y - dy, y + dy };
+        for (int32_t r = 0; r < (dy == 0 ? 1 : 2); ++r) {
+            int32_t row = rows[r];
+            if (row < y0 || row > y1) continue;
+            int32_t fx = nearest_free_in_row(x, row, x0, x1, gas_is_free);
+            if (fx < 0) continue;
+            int64_t d = (int64_t)(fx - x) * (fx - x) + (int64_t)dy * dy;
+            if (d < best) {
+                best = d;
+                *out_x = fx;
+                *out_y = row;
+            }
+        }
+    }
+    return best != INT64_MAX;
+}
+
+void OccupancyBitmap::set_range(std::vector<uint64_t>& plane, int32_t y, int32_t x0, int32_t x1) const {
+    size_t row = (size_t)y * m_wordsPerRow;
+    for (int32_t word = x0 >> 6; x0 <= x1; ++word) {
+        int32_t end = std::min(x1, (word << 6) + 63);
+        plane[row + word] |= span_mask(x0, end);
+        x0 = end + 1;
+    }
+}
+
+void OccupancyBitmap::update_drain_row(int32_t y) {
+    size_t row = (size_t)y * m_wordsPerRow;
+    std::fill_n(&m_drain_left[row], m_wordsPerRow, 0ull);
+    std::fill_n(&m_drain_right[row], m_wordsPerRow, 0ull);
+
+    // 只有被托住的液体会读这一层，行里没有时不用计算
+    if (y + 1 >= m_height) return;
+    bool resting = false;
+    for (int32_t word = 0; word < m_wordsPerRow && !resting; ++word) {
+        resting = (liquid_word(y, word) & ~free_word(y + 1, word, true)) != 0;
+    }
+    if (!resting) return;
+
+    int32_t start = 0;  // 当前连通段的第一格
+    int32_t prev = -1;  // 当前连通段中上一个落点，还没有时为 -1
+    // 相邻两个落点之间的格子各自朝较近的一个，距离相等时向左；段首到第一个落点向右，最后一个落点到段尾向左
+    auto drop_at = [&](int32_t x) {
+        if (prev < 0) {
+            set_range(m_drain_right, y, start, x - 1);
+        } else {
+            int32_t mid = (prev + x) / 2;
+            set_range(m_drain_left, y, prev + 1, mid);
+            set_range(m_drain_right, y, mid + 1, x - 1);
+        }
+        prev = x;
+    };
+    auto end_segment = [&](int32_t x) {
+        if (prev >= 0) set_range(m_drain_left, y, prev + 1, x - 1);
+        start = x + 1;
+        prev = -1;
+    };
+
+    for (int32_t word = 0; word < m_wordsPerRow; ++word) {
+        // 行尾超出宽度的位是占用的，不在任何连通段内
+        uint64_t span = free_word(y, word, true) | liquid_word(y, word);
+        uint64_t drop = span & free_word(y + 1, word, true);
+        int32_t base = word << 6;
+        // 整个字都不在段内，或者整个字都是落点（下面是空的）时，字内没有需要方向的格子
+        if (span == 0) {
+            end_segment(base);
+            start = base + 64;
+            continue;
+        }
+        if (drop == ~0ull) {
+            drop_at(base);
+            prev = base + 63;
+            continue;
+        }
+        // 只在落点和段的边界处处理，其余格子在下一个事件时成段填写
+        uint64_t events = drop | ~span;
+        while (events) {
+            int32_t b = std::countr_zero(events);
+            events &= events - 1;
+            if ((drop >> b) & 1) drop_at(base + b);
+            else end_segment(base + b);
+        }
+    }
+    end_segment(m_wordsPerRow << 6);
+}
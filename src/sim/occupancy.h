@@ -0,0 +1,115 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+
+// 每格 1 位的占用位图，另有液体、气体两层，由 write_data 维护。
+// 每行按 64 位字对齐，行尾多出的位永远视为占用。
+// 同一阶段的区块之间可能共享同一个字，所以读写都通过 atomic_ref 完成。
+//
+// 查询时“可通过”的格子是空格，加上可选的气体层（液体可以挤开气体）。
+class OccupancyBitmap {
+public:
+    void resize(int32_t width, int32_t height);
+    void clear();
+
+    void set(int32_t x, int32_t y, bool occupied, bool liquid, bool gas)
+    {
+        int32_t word = y * m_wordsPerRow + (x >> 6);
+        uint64_t bit = 1ull << (x & 63);
+        set_bit(m_occupied[word], bit, occupied);
+        set_bit(m_liquid[word], bit, liquid);
+        set_bit(m_gas[word], bit, gas);
+    }
+
+    // 整个字一起更新占用层：set 位改为占用，clear 位改为空格，液体、气体层不变。
+    // 只用于粉末和空格之间的移动（位板快速路径）
+    void update_occupied(int32_t y, int32_t word, uint64_t set, uint64_t clear)
+    {
+        std::atomic_ref<uint64_t> ref(m_occupied[y * m_wordsPerRow + word]);
+        if (clear) ref.fetch_and(~clear, std::memory_order_relaxed);
+        if (set) ref.fetch_or(set, std::memory_order_relaxed);
+    }
+
+    bool occupied(int32_t x, int32_t y) const
+    {
+        return (load(m_occupied[y * m_wordsPerRow + (x >> 6)]) >> (x & 63)) & 1u;
+    }
+
+    // 第 y 行第 word 个字中可通过的位
+    uint64_t free_word(int32_t y, int32_t word, bool gas_is_free) const
+    {
+        int32_t i = y * m_wordsPerRow + word;
+        uint64_t free = ~load(m_occupied[i]);
+        if (gas_is_free) free |= load(m_gas[i]);
+        return free;
+    }
+
+    // 第 y 行第 word 个字中的液体位
+    uint64_t liquid_word(int32_t y, int32_t word) const
+    {
+        return load(m_liquid[y * m_wordsPerRow + word]);
+    }
+
+    // [x0, x1] 内可通过格子的数量，超出边界的部分不计
+    int32_t count_free(int32_t y, int32_t x0, int32_t x1, bool gas_is_free) const;
+
+    // 从 x 的下一格开始沿 dir（1 或 -1）方向连续可通过的格数，最多 max_len
+    int32_t free_run(int32_t x, int32_t y, int32_t dir, int32_t max_len, bool gas_is_free) const;
+
+    // 在 [x0, x1] x [y0, y1] 窗口内寻找离 (x, y) 最近（欧氏距离）的空格
+    bool find_nearest_free(int32_t x, int32_t y, int32_t x0, int32_t y0, int32_t x1, int32_t y1,
+                           bool gas_is_free, int32_t* out_x, int32_t* out_y) const;
+
+    // 第 y 行 [x0, x1] 内离 x 最近的可通过格子，找不到返回 -1
+    int32_t nearest_free_in_row(int32_t x, int32_t y, int32_t x0, int32_t x1, bool gas_is_free) const;
+
+    // 重新计算第 y 行的落点方向层：由可通过格子和液体组成的连通段内，每格朝最近的落点（下一行可通过的格子）
+    // 是向左还是向右。搜索距离不受限制，只能在没有格子移动的时候调用（每帧区块更新之前）
+    void update_drain_row(int32_t y);
+
+    // 落点方向层的查询：-1 向左，1 向右，0 表示连通段内没有落点或 (x, y) 本身就是落点
+    int32_t drain_side(int32_t x, int32_t y) const
+    {
+        size_t i = (size_t)y * m_wordsPerRow + (x >> 6);
+        uint64_t bit = 1ull << (x & 63);
+        return (m_drain_right[i] & bit) ? 1 : (m_drain_left[i] & bit) ? -1 : 0;
+    }
+
+    int32_t words_per_row() const { return m_wordsPerRow; }
+
+private:
+    static uint64_t load(const uint64_t& word)
+    {
+        return std::atomic_ref<uint64_t>(const_cast<uint64_t&>(word)).load(std::memory_order_relaxed);
+    }
+
+    // 第 y 行 [x0, x1]（已裁剪到世界内）中第一个（reverse 时最后一个）可通过的格子，找不到返回 -1
+    int32_t find_free(int32_t y, int32_t x0, int32_t x1, bool gas_is_free, bool reverse) const;
+
+    static void set_bit(uint64_t& word, uint64_t bit, bool value)
+    {
+        std::atomic_ref<uint64_t> ref(word);
+        if (value) ref.fetch_or(bit, std::memory_order_relaxed);
+        else ref.fetch_and(~bit, std::memory_order_relaxed);
+    }
+
+    // 把 plane 第 y 行的 [x0, x1] 置位，x0 > x1 时不做任何事
+    void set_range(std::vector<uint64_t>& plane, int32_t y, int32_t x0, int32_t x1) const;
+
+    // 字内 [x0 & 63, x1 & 63] 位的掩码，x0 / x1 需在同一个字内
+    static uint64_t span_mask(int32_t x0, int32_t x1)
+    {
+        uint64_t hi = (x1 & 63) == 63 ? ~0ull : ((1ull << ((x1 & 63) + 1)) - 1);
+        uint64_t lo = ~0ull << (x0 & 63);
+        return hi & lo;
+    }
+
+    int32_t m_width = 0, m_height = 0;
+    int32_t m_wordsPerRow = 0;
+    std::vector<uint64_t> m_occupied;
+    std::vector<uint64_t> m_liquid;
+    std::vector<uint64_t> m_gas;
+    std::vector<uint64_t> m_drain_left;     // update_drain_row 的结果，不随 set 更新
+    std::vector<uint64_t> m_drain_right;
+};
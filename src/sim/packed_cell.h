@@ -0,0 +1,81 @@
+#pragma once
+#include <stdint.h>
+
+#include "Math.h"
+
+// 8 字节紧凑格子编码：
+//
+//   bits  0- 7  id
+//   bits  8-11  颜色渐变档（0-15，对应 MATERIAL_MAX_VARIATIONS）
+//   bits 12-15  标志位 PACKED_FLAG_*
+//   bits 16-31  lifetime，无符号 8.8 定点（秒）
+//   bits 32-47  velocity.x，有符号 8.8 定点（格/帧）
+//   bits 48-63  velocity.y，有符号 8.8 定点（格/帧）
+//
+// 颜色不存储，解码时由 id 和渐变档从材质表查出。亚格位移余量只保存在网格中，导入的格子从 0 开始累积。
+typedef uint64_t PackedCell;
+
+#define PACKED_FLAG_UPDATED (1u << 0)   // 本 tick 已经更新过
+#define PACKED_FLAG_FREE_FALL (1u << 1) // 运动方向上的下一格可以进入，下一个 tick 会继续下落
+
+#define FIXED_ONE 256
+
+static inline int16_t fixed_from_float(float v)
+{
+    float f = v * (float)FIXED_ONE;
+    f = f > 32767.f ? 32767.f : f < -32768.f ? -32768.f : f;
+    return (int16_t)f;
+}
+
+static inline float fixed_to_float(int32_t v)
+{
+    return (float)v * (1.f / (float)FIXED_ONE);
+}
+
+static inline PackedCell pack_cell(uint8_t id, uint8_t variation, float lifetime, Vec2 velocity, uint8_t flags)
+{
+    float life = lifetime * (float)FIXED_ONE;
+    uint16_t life_fx = (uint16_t)(life > 65535.f ? 65535.f : life < 0.f ? 0.f : life);
+    return (PackedCell)id
+         | (PackedCell)(variation & 0x0F) << 8
+         | (PackedCell)(flags & 0x0F) << 12
+         | (PackedCell)life_fx << 16
+         | (PackedCell)(uint16_t)fixed_from_float(velocity.x) << 32
+         | (PackedCell)(uint16_t)fixed_from_float(velocity.y) << 48;
+}
+
+static inline uint8_t packed_id(PackedCell c) { return (uint8_t)c; }
+static inline uint8_t packed_variation(PackedCell c) { return (uint8_t)(c >> 8) & 0x0F; }
+static inline uint8_t packed_flags(PackedCell c) { return (uint8_t)(c >> 12) & 0x0F; }
+static inline float packed_lifetime(PackedCell c) { return fixed_to_float((uint16_t)(c >> 16)); }
+static inline int16_t packed_velocity_x_fx(PackedCell c) { return (int16_t)(uint16_t)(c >> 32); }
+static inline int16_t packed_velocity_y_fx(PackedCell c) { return (int16_t)(uint16_t)(c >> 48); }
+
+static inline Vec2 packed_velocity(PackedCell c)
+{
+    return Vec2{fixed_to_float(packed_velocity_x_fx(c)), fixed_to_float(packed_velocity_y_fx(c))};
+}
+
+static inline PackedCell packed_with_velocity_fx(PackedCell c, int16_t vx, int16_t vy)
+{
+    return (c & 0x00000000FFFFFFFFull) | (PackedCell)(uint16_t)vx << 32 | (PackedCell)(uint16_t)vy << 48;
+}
+
+// 定点速度加上格子的亚格余量（1/256 格）后本帧的整数位移，新的余量写回 remainder。
+// 小数部分在每个格子上累积而不是每帧被截断，例如 1.5 格/帧的粒子交替移动 1 格和 2 格
+static inline int32_t fixed_advance(int32_t v_fx, uint8_t& remainder)
+{
+    int32_t total = v_fx + remainder;
+    remainder = (uint8_t)(total & 0xFF);
+    // 算术右移即向下取整，负速度同样正确
+    return total >> 8;
+}
+
+// 重力方向的位移，至少一格；强制走的一格已经超过累积的位移，余量清零
+static inline int32_t fixed_fall(int32_t v_fx, uint8_t& remainder)
+{
+    int32_t fall = fixed_advance(v_fx, remainder);
+    if (fall >= 1) return fall;
+    remainder = 0;
+    return 1;
+}
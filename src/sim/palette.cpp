@@ -0,0 +1,58 @@
+#include "palette.h"
+#include <algorithm>
+
+#include "Utilities.h"
+#include "material_registry.h"
+
+static_assert(PALETTE_ROWS_PER_VIEW == MATERIAL_MAX_VARIATIONS, "palette rows must cover every variation");
+static_assert(PALETTE_WIDTH == MATERIAL_MAX_COUNT, "palette columns must cover every material id");
+
+static Color lerp_color(Color a, Color b, float t) {
+    return Color { (uint8_t)Utilities::interp_linear(a.r, b.r, t), (uint8_t)Utilities::interp_linear(a.g, b.g, t),
+                   (uint8_t)Utilities::interp_linear(a.b, b.b, t), (uint8_t)Utilities::interp_linear(a.a, b.a, t) };
+}
+
+// 黑体辐射风格的渐变：常温为深蓝，依次经过红、橙、黄到白
+static Color heat_color(float celsius) {
+    static const Color ramp[] = {
+        {10, 10, 40, 255}, {120, 10, 10, 255}, {230, 80, 0, 255}, {255, 200, 40, 255}, {255, 255, 230, 255}};
+    const int32_t last = (int32_t)(sizeof(ramp) / sizeof(ramp[0])) - 1;
+    float t = std::clamp((celsius - 20.f) / 1200.f, 0.f, 1.f) * (float)last;
+    int32_t i = std::min((int32_t)t, last - 1);
+    return lerp_color(ramp[i], ramp[i + 1], t - (float)i);
+}
+
+static Color phase_color(uint8_t phase) {
+    switch (phase) {
+    case PHASE_SOLID: return Color {160, 160, 160, 255};
+    case PHASE_POWDER: return Color {230, 190, 60, 255};
+    case PHASE_LIQUID: return Color {40, 110, 230, 255};
+    case PHASE_GAS: return Color {200, 80, 200, 255};
+    default: return mat_col_empty;
+    }
+}
+
+void build_palette(const MaterialRegistry& materials, std::vector<Color>& out) {
+    const MaterialTable& table = materials.table();
+    out.assign((size_t)PALETTE_WIDTH * PALETTE_HEIGHT, mat_col_empty);
+
+    auto texel = [&](uint32_t view, uint32_t id, uint32_t variation) -> Color& {
+        return out[(size_t)(view * PALETTE_ROWS_PER_VIEW + variation) * PALETTE_WIDTH + id];
+    };
+
+    for (uint32_t id = 0; id < PALETTE_WIDTH; ++id) {
+        // 空格子在所有视图中都保持透明
+        if (id == mat_id_empty) continue;
+        uint32_t count = std::max<uint32_t>(table.variation_count[id], 1);
+
+        for (uint32_t v = 0; v < PALETTE_ROWS_PER_VIEW; ++v) {
+            // 超出材质档数的行用最后一档填满，防止旧数据中的越界颜色档取到黑色
+            uint32_t variation = std::min(v, count - 1);
+            texel(PALETTE_VIEW_COLOR, id, v) = table.colors[id][variation];
+            texel(PALETTE_VIEW_HEAT, id, v) = heat_color(materials.def((uint8_t)id).temperature);
+
+            float shade = count > 1 ? 0.7f + 0.3f * (float)variation / (float)(count - 1) : 1.f;
+            texel(PALETTE_VIEW_PHASE, id, v) = lerp_color(Color {0, 0, 0, 255}, phase_color(table.phase[id]), shade);
+        }
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+
+#include "ParticleSim.h"
+
+class MaterialRegistry;
+
+// 调色板中的视图，每个视图占 PALETTE_ROWS_PER_VIEW 行，着色器按 push constant 选择
+enum PaletteView : uint8_t {
+    PALETTE_VIEW_COLOR = 0,  // 材质颜色渐变，与 colors() 的输出一致
+    PALETTE_VIEW_HEAT,       // 按材质温度着色
+    PALETTE_VIEW_PHASE,      // 调试：按物态着色，颜色档用明暗区分
+    PALETTE_VIEW_COUNT
+};
+
+// 调色板纹理：宽 256（材质 id），高 PALETTE_ROWS_PER_VIEW * PALETTE_VIEW_COUNT，
+// 视图 v 中 (id, variation) 的颜色位于 texel(id, v * PALETTE_ROWS_PER_VIEW + variation)
+#define PALETTE_WIDTH 256
+#define PALETTE_ROWS_PER_VIEW 16
+#define PALETTE_HEIGHT (PALETTE_ROWS_PER_VIEW * PALETTE_VIEW_COUNT)
+
+// 由材质表生成整张调色板（PALETTE_WIDTH * PALETTE_HEIGHT，按行存储），材质重新加载后需要重建
+void build_palette(const MaterialRegistry& materials, std::vector<Color>& out);
@@ -0,0 +1,159 @@
+#pragma once
+// 单一粉末材质区块的位板快速路径。
+// 区块宽 64 格，每行正好对应占用位图中的一个字：下落和斜向滑落都用整行的位运算求出，
+// 只对真正移动的颗粒逐个调用 move_to。只应被 ParticleSim.cpp 包含。
+#include <bit>
+#include <cmath>
+
+#include "ParticleSim.h"
+#include "Utilities.h"
+#include "simd.h"
+
+static_assert(SIM_CHUNK_SIZE == 64, "bitboard rows map one chunk row to one occupancy word");
+
+// [lo, hi] 位为 1 的掩码，0 <= lo <= hi <= 63
+static inline uint64_t bitboard_span(int32_t lo, int32_t hi)
+{
+    uint64_t upper = hi == 63 ? ~0ull : ((1ull << (hi + 1)) - 1);
+    return upper & (~0ull << lo);
+}
+
+// 把 idx 处的颗粒和 idx + offset 处的空格交换，两格都标记为本帧已更新。
+// 与 move_to 相同，只是不逐格维护占用位图和脏矩形
+inline void ParticleSimulator::bitboard_swap(int32_t idx, int32_t offset)
+{
+    int32_t target = idx + offset;
+    std::swap(m_grid.id[idx], m_grid.id[target]);
+    std::swap(m_grid.lifetime[idx], m_grid.lifetime[target]);
+    std::swap(m_grid.velocity[idx], m_grid.velocity[target]);
+    std::swap(m_grid.variation[idx], m_grid.variation[target]);
+    std::swap(m_grid.frac_x[idx], m_grid.frac_x[target]);
+    std::swap(m_grid.frac_y[idx], m_grid.frac_y[target]);
+    m_grid.updated[idx] = 1;
+    m_grid.updated[target] = 1;
+}
+
+// 区块（脏矩形向外一圈）内只有一种可用位板的粉末和空格时按位板更新并返回 true，否则返回 false，
+// 由调用者走逐格更新。规则与 update_movement<ARCHETYPE_POWDER> 相同：能下落一格就下落，
+// 否则速度减半并按随机顺序尝试两侧的斜下方，旁边的格子也被占着时不斜滑；区块内没有其他材质，可置换的只有空格。
+// 区块最底行、左右两列的颗粒可能移进相邻区块，下落速度超过一格的颗粒需要逐格检查路径，都交给 update_cell
+inline bool ParticleSimulator::update_chunk_bitboard(int32_t cx, int32_t cy)
+{
+    const SimChunk& c = m_chunks[cy * m_chunkCountX + cx];
+    if (c.min_x > c.max_x || c.min_y > c.max_y) return true;
+
+    int32_t base_x = cx * SIM_CHUNK_SIZE;
+    int32_t last_x = std::min(base_x + SIM_CHUNK_SIZE, m_textureWidth) - 1;
+    int32_t last_y = std::min((cy + 1) * SIM_CHUNK_SIZE, m_textureHeight) - 1;
+    const SimKernels& kernels = simd_kernels();
+
+    // 检查范围覆盖所有位移的起点和终点
+    int32_t sx0 = std::max(c.min_x - 1, base_x);
+    int32_t sx1 = std::min(c.max_x + 1, last_x);
+    int32_t sy1 = std::min(c.max_y + 1, last_y);
+    uint64_t scan = bitboard_span(sx0 - base_x, sx1 - base_x);
+
+    uint8_t material = mat_id_empty;
+    for (int32_t y = c.min_y; y <= sy1 && material == mat_id_empty; ++y) {
+        uint64_t occupied = ~m_occupancy.free_word(y, cx, false) & scan;
+        if (occupied) material = m_grid.id[compute_idx(base_x + std::countr_zero(occupied), y)];
+    }
+    if (material == mat_id_empty) return true;
+    if (!m_bitboard_table[material]) return false;
+
+    // 自下而上检查，其他材质（沉在下面的液体等）通常在底部，能更早退出
+    for (int32_t y = sy1; y >= c.min_y; --y) {
+        const uint8_t* ids = &m_grid.id[compute_idx(sx0, y)];
+        int32_t n = sx1 - sx0 + 1;
+        uint64_t known = kernels.match_mask(ids, n, mat_id_empty) | kernels.match_mask(ids, n, material);
+        if (known != bitboard_span(0, n - 1)) return false;
+    }
+
+    constexpr uint64_t edges = 1ull | (1ull << 63);
+    uint64_t rect = bitboard_span(c.min_x - base_x, c.max_x - base_x);
+
+    // 自下而上：处理第 y 行时下一行已经是本帧的最终状态
+    for (int32_t y = c.max_y; y >= c.min_y; --y) {
+        int32_t row = compute_idx(base_x, y);
+        // 相邻区块在更早的阶段移进来的颗粒本帧不再移动
+        uint64_t fresh = kernels.match_mask(&m_grid.updated[row], last_x - base_x + 1, 0);
+        uint64_t grains = ~m_occupancy.free_word(y, cx, false) & rect & fresh;
+
+        if (y == last_y) {
+            for (uint64_t bits = grains; bits; bits &= bits - 1) update_cell(base_x + std::countr_zero(bits), y);
+            continue;
+        }
+        uint64_t edge_grains = grains & edges;
+        grains &= ~edges;
+
+        // 一次要下落多格的颗粒先逐格更新，它们总会向下移动
+        uint64_t below = ~m_occupancy.free_word(y + 1, cx, false);
+        uint64_t fast = 0;
+        for (uint64_t bits = grains & ~below; bits; bits &= bits - 1) {
+            int32_t bit = std::countr_zero(bits);
+            float speed = std::fabs(m_grid.velocity[row + bit].y);
+            uint8_t frac = m_grid.frac_y[row + bit];
+            if (fixed_fall(fixed_from_float(speed), frac) > 1) fast |= 1ull << bit;
+        }
+        if (fast) {
+            for (uint64_t bits = fast; bits; bits &= bits - 1) update_cell(base_x + std::countr_zero(bits), y);
+            grains &= ~fast;
+            below = ~m_occupancy.free_word(y + 1, cx, false);
+        }
+
+        uint64_t falling = grains & ~below;
+        below |= falling;
+
+        // 被挡住的颗粒速度减半，随机位为 1 的先试右下方；每一步都避开之前已经占用的目标。
+        // 下方被挡住，斜滑还要求同一行旁边的格子是空的（本帧下落的颗粒已经离开），与 trace_path 一致
+        uint64_t blocked = grains & ~falling;
+        uint64_t side_free = m_occupancy.free_word(y, cx, false) | falling;
+        for (uint64_t bits = blocked; bits; bits &= bits - 1) {
+            int32_t i = row + std::countr_zero(bits);
+            m_grid.velocity[i].y *= 0.5f;
+            m_grid.frac_x[i] = 0;
+            m_grid.frac_y[i] = 0;
+        }
+        uint64_t right_first = Utilities::random_bits64();
+        uint64_t can_right = blocked & (side_free >> 1);
+        uint64_t can_left = blocked & (side_free << 1);
+        uint64_t right = can_right & right_first & (~below >> 1);
+        below |= right << 1;
+        uint64_t left = can_left & ~right_first & (~below << 1);
+        below |= left >> 1;
+        uint64_t right_second = can_right & ~right_first & ~left & (~below >> 1);
+        below |= right_second << 1;
+        uint64_t left_second = can_left & right_first & ~right & (~below << 1);
+        right |= right_second;
+        left |= left_second;
+
+        // 起点都在第 y 行、终点都在第 y + 1 行且互不相同，移动顺序无关。
+        // 区块内只有粉末和空格，直接交换各平面，占用位图和脏矩形按整行更新
+        uint64_t moved = falling | right | left;
+        if (moved) {
+            // 下落一格的颗粒按 update_movement 的规则更新亚格余量
+            for (uint64_t bits = falling; bits; bits &= bits - 1) {
+                int32_t i = row + std::countr_zero(bits);
+                fixed_fall(fixed_from_float(std::fabs(m_grid.velocity[i].y)), m_grid.frac_y[i]);
+                bitboard_swap(i, m_neighbor_offset[NEIGHBOR_DOWN]);
+            }
+            for (uint64_t bits = right; bits; bits &= bits - 1) {
+                bitboard_swap(row + std::countr_zero(bits), m_neighbor_offset[NEIGHBOR_DOWN_RIGHT]);
+            }
+            for (uint64_t bits = left; bits; bits &= bits - 1) {
+                bitboard_swap(row + std::countr_zero(bits), m_neighbor_offset[NEIGHBOR_DOWN_LEFT]);
+            }
+
+            uint64_t targets = falling | (right << 1) | (left >> 1);
+            m_occupancy.update_occupied(y, cx, 0, moved);
+            m_occupancy.update_occupied(y + 1, cx, targets, 0);
+            mark_dirty(base_x + std::countr_zero(moved), y);
+            mark_dirty(base_x + 63 - std::countl_zero(moved), y);
+            mark_dirty(base_x + std::countr_zero(targets), y + 1);
+            mark_dirty(base_x + 63 - std::countl_zero(targets), y + 1);
+        }
+
+        for (uint64_t bits = edge_grains; bits; bits &= bits - 1) update_cell(base_x + std::countr_zero(bits), y);
+    }
+    return true;
+}
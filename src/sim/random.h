@@ -0,0 +1,93 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// 基于计数器的随机数生成器。
+// 输出只由 (key, counter) 决定，没有共享状态：同一个 key 下第 n 个随机数在任何线程、
+// 任何调用顺序下都相同，这是并行更新保持逐位一致的前提。
+// key 由世界种子、帧号和区块/格子索引派生。
+
+// SplitMix64 的终结混合函数，用于派生 key
+static inline uint64_t random_mix64(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+static inline uint64_t random_key(uint64_t world_seed, uint64_t frame, uint64_t stream)
+{
+    return random_mix64(world_seed ^ random_mix64(frame ^ random_mix64(stream)));
+}
+
+// 单个随机字：两轮 32 位混合，只用 32 位乘法，便于批量版本向量化
+static inline uint32_t random_bits(uint64_t key, uint32_t counter)
+{
+    uint32_t x = counter * 0x9E3779B9u + (uint32_t)key;
+    x ^= x >> 16; x *= 0x7FEB352Du; x ^= x >> 15; x *= 0x846CA68Bu; x ^= x >> 16;
+    x ^= (uint32_t)(key >> 32);
+    x ^= x >> 16; x *= 0x7FEB352Du; x ^= x >> 15; x *= 0x846CA68Bu; x ^= x >> 16;
+    return x;
+}
+
+// 批量生成 out[i] = random_bits(key, first_counter + i)，一次填满一个区块大小的缓冲区
+void random_fill(uint64_t key, uint32_t first_counter, uint32_t* out, size_t count);
+
+// 顺序读取的随机流，内部按块调用 random_fill
+class RandomStream {
+public:
+    void seed(uint64_t key)
+    {
+        m_key = key;
+        m_counter = 0;
+        m_pos = BLOCK_SIZE;
+    }
+
+    uint32_t next()
+    {
+        if (m_pos == BLOCK_SIZE) {
+            random_fill(m_key, m_counter, m_block, BLOCK_SIZE);
+            m_counter += BLOCK_SIZE;
+            m_pos = 0;
+        }
+        return m_block[m_pos++];
+    }
+
+    // [lower, upper] 内均匀分布的整数，使用拒绝采样去除取模偏差
+    int32_t range(int32_t lower, int32_t upper)
+    {
+        if (upper < lower) {
+            int32_t tmp = lower;
+            lower = upper;
+            upper = tmp;
+        }
+        uint32_t span = (uint32_t)(upper - lower) + 1u;
+        if (span == 0) return (int32_t)next();
+
+        uint64_t m = (uint64_t)next() * span;
+        uint32_t low = (uint32_t)m;
+        if (low < span) {
+            uint32_t threshold = (0u - span) % span;
+            while (low < threshold) {
+                m = (uint64_t)next() * span;
+                low = (uint32_t)m;
+            }
+        }
+        return lower + (int32_t)(m >> 32);
+    }
+
+    // [0, 1) 内的浮点数
+    float uniform()
+    {
+        return (float)(next() >> 8) * (1.f / 16777216.f);
+    }
+
+private:
+    static constexpr uint32_t BLOCK_SIZE = 64;
+
+    uint64_t m_key = 0;
+    uint32_t m_counter = 0;
+    uint32_t m_pos = BLOCK_SIZE;
+    uint32_t m_block[BLOCK_SIZE];
+};
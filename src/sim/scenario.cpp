@@ -0,0 +1,123 @@
+#include "scenario.h"
+#include <fstream>
+#include <sstream>
+#include <spdlog/spdlog.h>
+
+#include "ParticleSim.h"
+#include "material_registry.h"
+
+bool load_scenario(const std::string& path, Scenario& out) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        spdlog::error("Scenario file not found: {}", path);
+        return false;
+    }
+
+    Scenario scenario;
+    scenario.name = path;
+    std::string section;
+    ScenarioBrush brush;
+    bool ok = true;
+
+    auto flush = [&]() {
+        if (section == "fill" || section == "brush") scenario.brushes.push_back(brush);
+    };
+
+    std::string line;
+    int32_t line_number = 0;
+    while (std::getline(file, line)) {
+        ++line_number;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+
+        size_t begin = line.find_first_not_of(" \t\r");
+        if (begin == std::string::npos) continue;
+        size_t end = line.find_last_not_of(" \t\r");
+        line = line.substr(begin, end - begin + 1);
+
+        if (line.front() == '[' && line.back() == ']') {
+            flush();
+            section = line.substr(1, line.size() - 2);
+            brush = ScenarioBrush{};
+            if (section != "world" && section != "fill" && section != "brush") {
+                spdlog::error("{}:{}: unknown section [{}]", path, line_number, section);
+                ok = false;
+            }
+            continue;
+        }
+
+        size_t eq = line.find('=');
+        if (eq == std::string::npos || section.empty()) {
+            spdlog::error("{}:{}: unexpected line '{}'", path, line_number, line);
+            ok = false;
+            continue;
+        }
+
+        std::string key = line.substr(0, line.find_last_not_of(" \t", eq - 1) + 1);
+        std::istringstream value(line.substr(eq + 1));
+        bool parsed = true;
+
+        if (section == "world") {
+            if (key == "width") parsed = (bool)(value >> scenario.width) && scenario.width > 0;
+            else if (key == "height") parsed = (bool)(value >> scenario.height) && scenario.height > 0;
+            else if (key == "seed") parsed = (bool)(value >> scenario.seed);
+            else if (key == "frames") parsed = (bool)(value >> scenario.frames);
+            else if (key == "threads") parsed = (bool)(value >> scenario.threads);
+            else if (key == "dt") parsed = (bool)(value >> scenario.dt) && scenario.dt > 0.f;
+            else if (key == "materials") parsed = (bool)(value >> scenario.materials);
+            else spdlog::warn("{}:{}: unknown key '{}'", path, line_number, key);
+        } else {
+            if (key == "material") {
+                parsed = (bool)(value >> brush.material);
+            } else if (key == "rect") {
+                brush.shape = ScenarioBrush::SHAPE_RECT;
+                parsed = (bool)(value >> brush.x0 >> brush.y0 >> brush.x1 >> brush.y1);
+            } else if (key == "circle") {
+                brush.shape = ScenarioBrush::SHAPE_CIRCLE;
+                parsed = (bool)(value >> brush.x >> brush.y >> brush.radius) && brush.radius >= 0;
+            } else if (key == "density") {
+                parsed = (bool)(value >> brush.density);
+            } else if (key == "frame" && section == "brush") {
+                parsed = (bool)(value >> brush.frame);
+            } else if (key == "repeat" && section == "brush") {
+                parsed = (bool)(value >> brush.repeat);
+            } else if (key == "interval" && section == "brush") {
+                parsed = (bool)(value >> brush.interval) && brush.interval > 0;
+            } else {
+                spdlog::warn("{}:{}: unknown key '{}'", path, line_number, key);
+            }
+        }
+
+        if (!parsed) {
+            spdlog::error("{}:{}: invalid value for '{}'", path, line_number, key);
+            ok = false;
+        }
+    }
+    flush();
+
+    if (!ok) {
+        spdlog::error("Failed to load scenario: {}", path);
+        return false;
+    }
+    out = scenario;
+    return true;
+}
+
+void apply_scenario_brushes(const Scenario& scenario, ParticleSimulator& sim, uint64_t frame) {
+    for (const ScenarioBrush& b : scenario.brushes) {
+        if (frame < b.frame || (frame - b.frame) % b.interval != 0) continue;
+        if ((frame - b.frame) / b.interval >= b.repeat) continue;
+
+        int32_t id = sim.materials().find(b.material);
+        if (id < 0) {
+            spdlog::warn("Scenario brush uses unknown material '{}'", b.material);
+            continue;
+        }
+
+        if (b.shape == ScenarioBrush::SHAPE_CIRCLE) {
+            sim.paint_circle(b.x, b.y, b.radius, (uint8_t)id, b.density);
+        } else {
+            sim.paint_rect(b.x0, b.y0, b.x1, b.y1, (uint8_t)id, b.density);
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+class ParticleSimulator;
+
+// 场景中的一次笔刷操作：在第 frame 帧开始前放置材质，可按 interval 帧重复 repeat 次。
+// 材质按名字记录，运行时在加载材质表之后再解析成 id。
+struct ScenarioBrush {
+    enum Shape { SHAPE_RECT = 0, SHAPE_CIRCLE };
+
+    Shape shape = SHAPE_RECT;
+    std::string material;
+    int32_t x0 = 0, y0 = 0, x1 = 0, y1 = 0; // 矩形（闭区间）
+    int32_t x = 0, y = 0, radius = 0;        // 圆
+    float density = 1.f;
+    uint64_t frame = 0;
+    uint32_t repeat = 1;
+    uint32_t interval = 1;
+};
+
+// 无头运行的场景，格式与材质文件相同（INI 风格）：
+//
+//   [world]
+//   width = 640
+//   height = 480
+//   seed = 1
+//   frames = 1000           # 运行的帧数
+//   threads = 0             # 0 表示使用全部硬件线程
+//   dt = 0.0166667          # 每帧固定的时间步长（秒）
+//   materials = assets/materials/materials.txt
+//
+//   [fill]                  # 初始填充，第 0 帧之前执行
+//   material = sand
+//   rect = 100 50 300 200   # x0 y0 x1 y1
+//   density = 0.7
+//
+//   [brush]                 # 脚本笔刷
+//   material = water
+//   circle = 320 20 8       # x y radius
+//   frame = 100
+//   repeat = 50
+//   interval = 4
+struct Scenario {
+    std::string name;
+    int32_t width = 640;
+    int32_t height = 480;
+    uint64_t seed = 0x5EED;
+    uint32_t frames = 600;
+    uint32_t threads = 0;
+    float dt = 1.f / 60.f;
+    std::string materials = "assets/materials/materials.txt";
+    std::vector<ScenarioBrush> brushes;
+};
+
+// 加载场景文件，失败时返回 false 并输出错误
+bool load_scenario(const std::string& path, Scenario& out);
+
+// 执行第 frame 帧开始前应用的笔刷，材质名无效的笔刷被跳过
+void apply_scenario_brushes(const Scenario& scenario, ParticleSimulator& sim, uint64_t frame);
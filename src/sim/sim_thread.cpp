@@ -0,0 +1,112 @@
+#include "sim_thread.h"
+#include <chrono>
+#include <cstring>
+
+SimulationThread::SimulationThread(ParticleSimulator* sim) : m_sim(sim) {
+    size_t cells = (size_t)sim->width() * sim->height();
+    SimRect world { 0, 0, sim->width() - 1, sim->height() - 1 };
+    for (uint32_t i = 0; i < 3; ++i) {
+        m_frames.slot(i).colors.resize(cells);
+        m_frames.slot(i).cells.resize(cells);
+        // 槽位里还什么都没有，第一次写入时整帧复制
+        m_stale[i].assign(1, world);
+    }
+    m_region_limit = 4 * (size_t)((sim->width() + SIM_CHUNK_SIZE - 1) / SIM_CHUNK_SIZE) *
+                     ((sim->height() + SIM_CHUNK_SIZE - 1) / SIM_CHUNK_SIZE);
+}
+
+SimulationThread::~SimulationThread() {
+    stop();
+}
+
+void SimulationThread::start() {
+    if (m_running.exchange(true)) return;
+    m_thread = std::thread(&SimulationThread::run, this);
+}
+
+void SimulationThread::stop() {
+    if (!m_running.exchange(false)) return;
+    if (m_thread.joinable()) m_thread.join();
+}
+
+void SimulationThread::post(std::function<void(ParticleSimulator&)> command) {
+    std::lock_guard<std::mutex> lock(m_command_mutex);
+    m_commands.push_back(std::move(command));
+}
+
+void SimulationThread::run_commands() {
+    {
+        std::lock_guard<std::mutex> lock(m_command_mutex);
+        m_pending.swap(m_commands);
+    }
+    for (auto& command : m_pending) command(*m_sim);
+    m_pending.clear();
+}
+
+void SimulationThread::append_changed_regions(SimFrame& frame) {
+    // 上一帧已被取走时从它开始重新累积；否则继续累积，让读取端跳过的帧不需要整帧上传
+    if (m_frames.published_taken()) {
+        m_changed.clear();
+        m_base_sequence = m_sequence;
+    }
+
+    m_sim->take_changed_regions(frame.regions);
+
+    // 读取端长时间不取帧、或者某个槽位很久没轮到写入时区域会越积越多，退化成一整块
+    SimRect world { 0, 0, m_sim->width() - 1, m_sim->height() - 1 };
+    auto accumulate = [&](std::vector<SimRect>& list) {
+        list.insert(list.end(), frame.regions.begin(), frame.regions.end());
+        if (list.size() > m_region_limit) list.assign(1, world);
+    };
+    accumulate(m_changed);
+    for (std::vector<SimRect>& stale : m_stale) accumulate(stale);
+
+    frame.regions = m_changed;
+    frame.sequence = ++m_sequence;
+    frame.base_sequence = m_base_sequence;
+}
+
+void SimulationThread::copy_stale_regions(SimFrame& frame, std::vector<SimRect>& stale) {
+    // 槽位里其余部分和模拟器当前的输出相同，只需要补上它错过的变化
+    int32_t width = m_sim->width();
+    bool palette = frame.output == SIM_OUTPUT_PALETTE;
+    size_t bpp = palette ? sizeof(PaletteCell) : sizeof(Color);
+    const uint8_t* src = palette ? (const uint8_t*)m_sim->palette_cells() : (const uint8_t*)m_sim->colors();
+    uint8_t* dst = palette ? (uint8_t*)frame.cells.data() : (uint8_t*)frame.colors.data();
+
+    for (const SimRect& r : stale) {
+        size_t row_bytes = (size_t)(r.x1 - r.x0 + 1) * bpp;
+        for (int32_t y = r.y0; y <= r.y1; ++y) {
+            size_t offset = ((size_t)y * width + r.x0) * bpp;
+            memcpy(dst + offset, src + offset, row_bytes);
+        }
+    }
+    stale.clear();
+}
+
+void SimulationThread::run() {
+    using clock = std::chrono::steady_clock;
+    auto last = clock::now();
+
+    while (m_running.load(std::memory_order_relaxed)) {
+        run_commands();
+
+        auto now = clock::now();
+        float dt = std::chrono::duration<float>(now - last).count();
+        last = now;
+
+        // 只在世界确实前进过时发布新帧
+        if (m_sim->update(dt) > 0) {
+            SimFrame& frame = m_frames.write_slot();
+            frame.output = m_sim->output();
+            append_changed_regions(frame);
+            copy_stale_regions(frame, m_stale[m_frames.write_index()]);
+            m_frames.publish();
+        }
+
+        // 快进模式下不休眠；否则睡到下一个 tick 到期
+        if (!m_sim->m_turbo) {
+            std::this_thread::sleep_for(std::chrono::duration<float>(m_sim->time_to_next_tick()));
+        }
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ParticleSim.h"
+#include "triple_buffer.h"
+
+// 发布给渲染线程的一帧
+struct SimFrame {
+    SimOutput output = SIM_OUTPUT_COLOR;
+    std::vector<Color> colors;          // width * height，SIM_OUTPUT_COLOR 时有效
+    std::vector<PaletteCell> cells;     // width * height，SIM_OUTPUT_PALETTE 时有效
+    std::vector<SimRect> regions;  // 相对 base_sequence 那一帧颜色变化过的区域
+    uint64_t sequence = 0;         // 从 1 开始连续编号
+    uint64_t base_sequence = 0;    // 发布时读取端最后取走的帧号，0 表示初始的空白纹理
+};
+
+// 在独立线程上运行 ParticleSimulator。
+// 每次执行过 tick 后把变化区域和其中的颜色复制到三缓冲中发布，渲染线程用 frames().acquire() 不阻塞地取最新一帧。
+// 每个槽位记录自己上次写入之后世界变化过的区域，发布时只复制这些区域，不复制整帧。
+// 没被取走就被覆盖的帧，其变化区域会并入后面的帧；读取端手里的帧号与 base_sequence 不同时需要整帧上传。
+// 模拟器只能在模拟线程上访问，其他线程通过 post 投递的命令在 tick 之间执行（例如笔刷、切换快进）。
+class SimulationThread {
+public:
+    explicit SimulationThread(ParticleSimulator* sim);
+    ~SimulationThread();
+
+    void start();
+    void stop();
+
+    // 投递一条在模拟线程上执行的命令
+    void post(std::function<void(ParticleSimulator&)> command);
+
+    TripleBuffer<SimFrame>& frames() { return m_frames; }
+
+private:
+    void run();
+    void run_commands();
+    void append_changed_regions(SimFrame& frame);
+    void copy_stale_regions(SimFrame& frame, std::vector<SimRect>& stale);
+
+    ParticleSimulator* m_sim;
+    TripleBuffer<SimFrame> m_frames;
+    uint64_t m_sequence = 0;
+    uint64_t m_base_sequence = 0;
+    std::vector<SimRect> m_changed;  // 自 m_base_sequence 以来累积的变化区域
+    std::vector<SimRect> m_stale[3]; // 每个槽位上次写入之后变化过、还没复制进去的区域
+    size_t m_region_limit = 0;       // 区域数超过它时退化成整个世界
+    std::thread m_thread;
+    std::atomic<bool> m_running { false };
+
+    std::mutex m_command_mutex;
+    std::vector<std::function<void(ParticleSimulator&)>> m_commands;
+    std::vector<std::function<void(ParticleSimulator&)>> m_pending; // 只由模拟线程访问
+};
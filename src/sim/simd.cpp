@@ -0,0 +1,139 @@
+#include "simd.h"
+#include <atomic>
+#include <cstring>
+#include <mutex>
+
+#include <spdlog/spdlog.h>
+
+#include "simd_kernels.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SIMD_X86 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+static std::mutex s_select_mutex;
+static std::atomic<bool> s_selected { false };
+static SimKernels s_kernels;
+static SimdLevel s_level = SIMD_SCALAR;
+
+#if SIMD_X86
+static void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4]) {
+#if defined(_MSC_VER)
+    __cpuidex((int*)regs, (int)leaf, (int)subleaf);
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// XCR0：操作系统在上下文切换时保存了哪些寄存器状态
+static uint64_t read_xcr0() {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((uint64_t)hi << 32) | lo;
+#endif
+}
+#endif
+
+SimdLevel simd_detect() {
+#if SIMD_X86
+    uint32_t r[4];
+    cpuid(0, 0, r);
+    uint32_t max_leaf = r[0];
+
+    cpuid(1, 0, r);
+    bool sse42 = (r[2] >> 20) & 1;
+    bool popcnt = (r[2] >> 23) & 1;
+    bool fma = (r[2] >> 12) & 1;
+    bool osxsave = (r[2] >> 27) & 1;
+    bool avx = (r[2] >> 28) & 1;
+    if (!sse42 || !popcnt) return SIMD_SCALAR;
+
+    // CPU 支持但操作系统没开启 YMM / ZMM 状态保存时同样不能用
+    uint64_t xcr0 = osxsave ? read_xcr0() : 0;
+    bool os_ymm = (xcr0 & 0x6) == 0x6;
+    bool os_zmm = (xcr0 & 0xe6) == 0xe6;
+    if (max_leaf < 7 || !avx || !os_ymm) return SIMD_SSE42;
+
+    cpuid(7, 0, r);
+    bool bmi1 = (r[1] >> 3) & 1;
+    bool avx2 = (r[1] >> 5) & 1;
+    bool bmi2 = (r[1] >> 8) & 1;
+    bool avx512f = (r[1] >> 16) & 1;
+    bool avx512dq = (r[1] >> 17) & 1;
+    bool avx512bw = (r[1] >> 30) & 1;
+    bool avx512vl = (r[1] >> 31) & 1;
+    if (!avx2 || !fma || !bmi1 || !bmi2) return SIMD_SSE42;
+    if (!avx512f || !avx512dq || !avx512bw || !avx512vl || !os_zmm) return SIMD_AVX2;
+    return SIMD_AVX512;
+#else
+    return SIMD_SCALAR;
+#endif
+}
+
+static SimdLevel select_locked(SimdLevel max_level) {
+    SimdLevel detected = simd_detect();
+    SimdLevel level = max_level < detected ? max_level : detected;
+
+    SimKernels kernels;
+    switch (level) {
+    case SIMD_AVX512: fill_kernels_avx512(kernels); break;
+    case SIMD_AVX2: fill_kernels_avx2(kernels); break;
+    case SIMD_SSE42: fill_kernels_sse42(kernels); break;
+    default: fill_kernels_scalar(kernels); break;
+    }
+    s_kernels = kernels;
+    s_level = level;
+    s_selected.store(true, std::memory_order_release);
+
+    spdlog::info("SIMD kernels: {} (detected {})", simd_level_name(level), simd_level_name(detected));
+    return level;
+}
+
+SimdLevel simd_select(SimdLevel max_level) {
+    std::lock_guard<std::mutex> lock(s_select_mutex);
+    return select_locked(max_level);
+}
+
+const SimKernels& simd_kernels() {
+    if (!s_selected.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(s_select_mutex);
+        if (!s_selected.load(std::memory_order_relaxed)) select_locked(SIMD_AVX512);
+    }
+    return s_kernels;
+}
+
+SimdLevel simd_level() {
+    simd_kernels();
+    return s_level;
+}
+
+const char* simd_level_name(SimdLevel level) {
+    switch (level) {
+    case SIMD_SSE42: return "sse4.2";
+    case SIMD_AVX2: return "avx2";
+    case SIMD_AVX512: return "avx512";
+    default: return "scalar";
+    }
+}
+
+bool parse_simd_level(const char* text, SimdLevel* out) {
+    if (strcmp(text, "auto") == 0) {
+        *out = SIMD_AVX512;
+        return true;
+    }
+    for (int32_t i = 0; i < SIMD_LEVEL_COUNT; ++i) {
+        if (strcmp(text, simd_level_name((SimdLevel)i)) == 0) {
+            *out = (SimdLevel)i;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <stdint.h>
+
+#include "ParticleSim.h"
+
+// 运行时按 CPU 选择的模拟内核。
+// 构建不带任何 ISA 编译选项，各级别的内核用函数级的 target 属性单独生成，
+// 启动时通过 cpuid 选出 CPU 和操作系统都支持的最高级别，同一个可执行文件在新旧机器上都能全速运行。
+enum SimdLevel : uint8_t {
+    SIMD_SCALAR = 0,
+    SIMD_SSE42,     // SSE4.2 + POPCNT
+    SIMD_AVX2,      // AVX2 + FMA + BMI1/2
+    SIMD_AVX512,    // AVX-512 F/BW/VL/DQ
+    SIMD_LEVEL_COUNT
+};
+
+struct SimKernels {
+    // 由 id 平面和颜色档平面生成一行颜色，lut 按 id * MATERIAL_MAX_VARIATIONS + variation 索引
+    void (*colorize_row)(const uint8_t* ids, const uint8_t* variations, const Color* lut, Color* out, int32_t count);
+    // 调色板模式：把两个平面交织成 PaletteCell
+    void (*pack_palette_row)(const uint8_t* ids, const uint8_t* variations, PaletteCell* out, int32_t count);
+    // 占用位图一行中连续 count 个字里可通过的格子数：~occupied | gas（gas 可为空），
+    // 首尾两个字分别与 first_mask / last_mask 相与
+    int32_t (*count_free_span)(const uint64_t* occupied, const uint64_t* gas, int32_t count,
+                               uint64_t first_mask, uint64_t last_mask);
+    // 同样的 count 个字里第一个可通过的格子（reverse 时为最后一个），返回相对 occupied[0] 第 0 位的位置，没有返回 -1
+    int32_t (*find_free_span)(const uint64_t* occupied, const uint64_t* gas, int32_t count,
+                              uint64_t first_mask, uint64_t last_mask, bool reverse);
+    // 把 count 个字节清零，用于每帧清除更新标记
+    void (*clear_bytes)(uint8_t* dst, int32_t count);
+    // 重力积分：velocity.y = clamp(velocity.y + accel[id], -max_speed[id], max_speed[id])。
+    // 不受重力的材质 accel 为 0、max_speed 为 FLT_MAX，速度保持不变；velocity.x 不变
+    void (*integrate_gravity)(const uint8_t* ids, Vec2* velocity, const float* accel, const float* max_speed,
+                              int32_t count);
+    // 位板：bytes[i] == value 时第 i 位为 1，count 不超过 64
+    uint64_t (*match_mask)(const uint8_t* bytes, int32_t count, uint8_t value);
+};
+
+// 当前选用的内核。第一次调用时若还没有 simd_select 过，自动选择检测到的最高级别
+const SimKernels& simd_kernels();
+SimdLevel simd_level();
+
+// CPU 和操作系统都支持的最高级别
+SimdLevel simd_detect();
+
+// 选择不超过 max_level 的最高可用级别并打印日志，返回实际选用的级别。
+// 只能在启动时、模拟开始之前调用
+SimdLevel simd_select(SimdLevel max_level = SIMD_AVX512);
+
+const char* simd_level_name(SimdLevel level);
+
+// 解析 --simd 的取值：scalar / sse4.2 / avx2 / avx512 / auto（auto 返回 SIMD_AVX512）
+bool parse_simd_level(const char* text, SimdLevel* out);
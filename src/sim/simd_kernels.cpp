@@ -0,0 +1,395 @@
+#include "simd_kernels.h"
+#include <atomic>
+#include <bit>
+#include <cstring>
+
+#include "material_registry.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define SIMD_X86 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define SIMD_NEON 1
+#endif
+
+// 构建不带 ISA 编译选项，各级别的函数用 target 属性单独生成代码；
+// 公共部分写成强制内联的函数，内联进带 target 属性的函数后按该级别的指令集编译。
+// MSVC 不需要编译选项就能使用所有内部函数
+#if defined(__GNUC__) || defined(__clang__)
+#define SIMD_TARGET(isa) __attribute__((target(isa)))
+#define SIMD_INLINE inline __attribute__((always_inline))
+#else
+#define SIMD_TARGET(isa)
+#define SIMD_INLINE __forceinline
+#endif
+
+#define TARGET_SSE42 SIMD_TARGET("sse4.2,popcnt")
+#define TARGET_AVX2 SIMD_TARGET("avx2,fma,bmi,bmi2,popcnt")
+#define TARGET_AVX512 SIMD_TARGET("avx512f,avx512bw,avx512vl,avx512dq,avx2,fma,bmi,bmi2,popcnt")
+
+static_assert(sizeof(Color) == 4 && sizeof(PaletteCell) == 2, "output texels must be tightly packed");
+static_assert(MATERIAL_MAX_VARIATIONS == 16, "lut index uses id << 4");
+static_assert(sizeof(Vec2) == 8, "velocity plane is interleaved x, y floats");
+
+// ---- 公共部分 ----
+
+SIMD_INLINE void colorize_tail(const uint8_t* ids, const uint8_t* variations, const Color* lut, Color* out, int32_t count) {
+    for (int32_t i = 0; i < count; ++i) {
+        out[i] = lut[ids[i] * MATERIAL_MAX_VARIATIONS + (variations[i] & (MATERIAL_MAX_VARIATIONS - 1))];
+    }
+}
+
+SIMD_INLINE void pack_palette_tail(const uint8_t* ids, const uint8_t* variations, PaletteCell* out, int32_t count) {
+    for (int32_t i = 0; i < count; ++i) out[i] = PaletteCell { ids[i], variations[i] };
+}
+
+// 占用位图在同一阶段可能被相邻区块写入，按字用 relaxed 原子读取
+SIMD_INLINE int32_t count_free_words(const uint64_t* occupied, const uint64_t* gas, int32_t count,
+                                     uint64_t first_mask, uint64_t last_mask) {
+    int32_t total = 0;
+    for (int32_t i = 0; i < count; ++i) {
+        uint64_t free = ~std::atomic_ref<const uint64_t>(occupied[i]).load(std::memory_order_relaxed);
+        if (gas) free |= std::atomic_ref<const uint64_t>(gas[i]).load(std::memory_order_relaxed);
+        if (i == 0) free &= first_mask;
+        if (i == count - 1) free &= last_mask;
+        total += std::popcount(free);
+    }
+    return total;
+}
+
+// 按 reverse 从前往后或从后往前找第一个不为 0 的字，再用 ctz / clz 取出其中的位
+SIMD_INLINE int32_t find_free_words(const uint64_t* occupied, const uint64_t* gas, int32_t count,
+                                    uint64_t first_mask, uint64_t last_mask, bool reverse) {
+    for (int32_t n = 0; n < count; ++n) {
+        int32_t i = reverse ? count - 1 - n : n;
+        uint64_t free = ~std::atomic_ref<const uint64_t>(occupied[i]).load(std::memory_order_relaxed);
+        if (gas) free |= std::atomic_ref<const uint64_t>(gas[i]).load(std::memory_order_relaxed);
+        if (i == 0) free &= first_mask;
+        if (i == count - 1) free &= last_mask;
+        if (free) return i * 64 + (reverse ? 63 - std::countl_zero(free) : std::countr_zero(free));
+    }
+    return -1;
+}
+
+// 与 utilities_clamp 相同：先和上限比较，再和下限比较
+SIMD_INLINE void integrate_gravity_tail(const uint8_t* ids, Vec2* velocity, const float* accel, const float* max_speed,
+                                        int32_t count) {
+    for (int32_t i = 0; i < count; ++i) {
+        float limit = max_speed[ids[i]];
+        float v = velocity[i].y + accel[ids[i]];
+        velocity[i].y = v > limit ? limit : v < -limit ? -limit : v;
+    }
+}
+
+SIMD_INLINE uint64_t match_mask_tail(const uint8_t* bytes, int32_t first, int32_t count, uint8_t value) {
+    uint64_t mask = 0;
+    for (int32_t i = first; i < count; ++i) mask |= (uint64_t)(bytes[i] == value) << i;
+    return mask;
+}
+
+// ---- 标量 ----
+
+static void colorize_row_scalar(const uint8_t* ids, const uint8_t* variations, const Color* lut, Color* out, int32_t count) {
+    colorize_tail(ids, variations, lut, out, count);
+}
+
+static void pack_palette_row_scalar(const uint8_t* ids, const uint8_t* variations, PaletteCell* out, int32_t count) {
+    int32_t i = 0;
+#if SIMD_X86
+    // SSE2 是 x86-64 的基线，字节交织正好得到 {id, variation}
+    for (; i + 16 <= count; i += 16) {
+        __m128i id = _mm_loadu_si128((const __m128i*)(ids + i));
+        __m128i var = _mm_loadu_si128((const __m128i*)(variations + i));
+        _mm_storeu_si128((__m128i*)(out + i), _mm_unpacklo_epi8(id, var));
+        _mm_storeu_si128((__m128i*)(out + i + 8), _mm_unpackhi_epi8(id, var));
+    }
+#elif SIMD_NEON
+    for (; i + 16 <= count; i += 16) {
+        uint8x16x2_t cells = { vld1q_u8(ids + i), vld1q_u8(variations + i) };
+        vst2q_u8((uint8_t*)(out + i), cells);
+    }
+#endif
+    pack_palette_tail(ids + i, variations + i, out + i, count - i);
+}
+
+static int32_t count_free_span_scalar(const uint64_t* occupied, const uint64_t* gas, int32_t count,
+                                      uint64_t first_mask, uint64_t last_mask) {
+    return count_free_words(occupied, gas, count, first_mask, last_mask);
+}
+
+static int32_t find_free_span_scalar(const uint64_t* occupied, const uint64_t* gas, int32_t count,
+                                     uint64_t first_mask, uint64_t last_mask, bool reverse) {
+    return find_free_words(occupied, gas, count, first_mask, last_mask, reverse);
+}
+
+static void clear_bytes_scalar(uint8_t* dst, int32_t count) {
+    memset(dst, 0, (size_t)count);
+}
+
+static void integrate_gravity_scalar(const uint8_t* ids, Vec2* velocity, const float* accel, const float* max_speed,
+                                     int32_t count) {
+    integrate_gravity_tail(ids, velocity, accel, max_speed, count);
+}
+
+static uint64_t match_mask_scalar(const uint8_t* bytes, int32_t count, uint8_t value) {
+    return match_mask_tail(bytes, 0, count, value);
+}
+
+void fill_kernels_scalar(SimKernels& k) {
+    k.colorize_row = colorize_row_scalar;
+    k.pack_palette_row = pack_palette_row_scalar;
+    k.count_free_span = count_free_span_scalar;
+    k.find_free_span = find_free_span_scalar;
+    k.clear_bytes = clear_bytes_scalar;
+    k.integrate_gravity = integrate_gravity_scalar;
+    k.match_mask = match_mask_scalar;
+}
+
+#if SIMD_X86
+
+// ---- SSE4.2 ----
+// 颜色查表没有 gather 可用，只有占用位图的计数用上 POPCNT 指令；清零一次写 16 字节
+
+TARGET_SSE42
+static void colorize_row_sse42(const uint8_t* ids, const uint8_t* variations, const Color* lut, Color* out, int32_t count) {
+    colorize_tail(ids, variations, lut, out, count);
+}
+
+TARGET_SSE42
+static int32_t count_free_span_sse42(const uint64_t* occupied, const uint64_t* gas, int32_t count,
+                                     uint64_t first_mask, uint64_t last_mask) {
+    return count_free_words(occupied, gas, count, first_mask, last_mask);
+}
+
+TARGET_SSE42
+static int32_t find_free_span_sse42(const uint64_t* occupied, const uint64_t* gas, int32_t count,
+                                    uint64_t first_mask, uint64_t last_mask, bool reverse) {
+    return find_free_words(occupied, gas, count, first_mask, last_mask, reverse);
+}
+
+TARGET_SSE42
+static void clear_bytes_sse42(uint8_t* dst, int32_t count) {
+    const __m128i zero = _mm_setzero_si128();
+    int32_t i = 0;
+    for (; i + 16 <= count; i += 16) _mm_storeu_si128((__m128i*)(dst + i), zero);
+    for (; i < count; ++i) dst[i] = 0;
+}
+
+// 没有 gather，按格查表后一次处理 2 格（4 个 float）
+TARGET_SSE42
+static void integrate_gravity_sse42(const uint8_t* ids, Vec2* velocity, const float* accel, const float* max_speed,
+                                    int32_t count) {
+    const __m128 sign = _mm_set1_ps(-0.f);
+    int32_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        float* v = (float*)(velocity + i);
+        __m128 a = _mm_setr_ps(0.f, accel[ids[i]], 0.f, accel[ids[i + 1]]);
+        __m128 m = _mm_setr_ps(0.f, max_speed[ids[i]], 0.f, max_speed[ids[i + 1]]);
+        __m128 old = _mm_loadu_ps(v);
+        __m128 r = _mm_max_ps(_mm_min_ps(_mm_add_ps(old, a), m), _mm_xor_ps(m, sign));
+        _mm_storeu_ps(v, _mm_blend_ps(old, r, 0xa));
+    }
+    integrate_gravity_tail(ids + i, velocity + i, accel, max_speed, count - i);
+}
+
+TARGET_SSE42
+static uint64_t match_mask_sse42(const uint8_t* bytes, int32_t count, uint8_t value) {
+    const __m128i v = _mm_set1_epi8((char)value);
+    uint64_t mask = 0;
+    int32_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(bytes + i)), v);
+        mask |= (uint64_t)(uint32_t)_mm_movemask_epi8(eq) << i;
+    }
+    return mask | match_mask_tail(bytes, i, count, value);
+}
+
+void fill_kernels_sse42(SimKernels& k) {
+    k.colorize_row = colorize_row_sse42;
+    k.pack_palette_row = pack_palette_row_scalar;
+    k.count_free_span = count_free_span_sse42;
+    k.find_free_span = find_free_span_sse42;
+    k.clear_bytes = clear_bytes_sse42;
+    k.integrate_gravity = integrate_gravity_sse42;
+    k.match_mask = match_mask_sse42;
+}
+
+// ---- AVX2 ----
+
+TARGET_AVX2
+static void colorize_row_avx2(const uint8_t* ids, const uint8_t* variations, const Color* lut, Color* out, int32_t count) {
+    const int* table = (const int*)lut;
+    const __m256i mask = _mm256_set1_epi32(MATERIAL_MAX_VARIATIONS - 1);
+    int32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i id = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(ids + i)));
+        __m256i var = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(variations + i)));
+        __m256i index = _mm256_add_epi32(_mm256_slli_epi32(id, 4), _mm256_and_si256(var, mask));
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_i32gather_epi32(table, index, 4));
+    }
+    colorize_tail(ids + i, variations + i, lut, out + i, count - i);
+}
+
+TARGET_AVX2
+static int32_t count_free_span_avx2(const uint64_t* occupied, const uint64_t* gas, int32_t count,
+                                    uint64_t first_mask, uint64_t last_mask) {
+    return count_free_words(occupied, gas, count, first_mask, last_mask);
+}
+
+TARGET_AVX2
+static int32_t find_free_span_avx2(const uint64_t* occupied, const uint64_t* gas, int32_t count,
+                                   uint64_t first_mask, uint64_t last_mask, bool reverse) {
+    return find_free_words(occupied, gas, count, first_mask, last_mask, reverse);
+}
+
+TARGET_AVX2
+static void clear_bytes_avx2(uint8_t* dst, int32_t count) {
+    const __m256i zero = _mm256_setzero_si256();
+    int32_t i = 0;
+    for (; i + 32 <= count; i += 32) _mm256_storeu_si256((__m256i*)(dst + i), zero);
+    if (i + 16 <= count) {
+        _mm_storeu_si128((__m128i*)(dst + i), _mm256_castsi256_si128(zero));
+        i += 16;
+    }
+    for (; i < count; ++i) dst[i] = 0;
+}
+
+// 一次 8 格：按 id 收集加速度和上限，再展开到 (x, y) 交错的两个寄存器，只写回 y
+TARGET_AVX2
+static void integrate_gravity_avx2(const uint8_t* ids, Vec2* velocity, const float* accel, const float* max_speed,
+                                   int32_t count) {
+    const __m256 sign = _mm256_set1_ps(-0.f);
+    const __m256i lo = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+    const __m256i hi = _mm256_setr_epi32(4, 4, 5, 5, 6, 6, 7, 7);
+    int32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i id = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(ids + i)));
+        __m256 a = _mm256_i32gather_ps(accel, id, 4);
+        __m256 m = _mm256_i32gather_ps(max_speed, id, 4);
+        float* v = (float*)(velocity + i);
+        for (int32_t half = 0; half < 2; ++half) {
+            __m256i spread = half ? hi : lo;
+            __m256 ha = _mm256_permutevar8x32_ps(a, spread);
+            __m256 hm = _mm256_permutevar8x32_ps(m, spread);
+            __m256 old = _mm256_loadu_ps(v + half * 8);
+            __m256 r = _mm256_max_ps(_mm256_min_ps(_mm256_add_ps(old, ha), hm), _mm256_xor_ps(hm, sign));
+            _mm256_storeu_ps(v + half * 8, _mm256_blend_ps(old, r, 0xaa));
+        }
+    }
+    integrate_gravity_tail(ids + i, velocity + i, accel, max_speed, count - i);
+}
+
+TARGET_AVX2
+static uint64_t match_mask_avx2(const uint8_t* bytes, int32_t count, uint8_t value) {
+    const __m256i v = _mm256_set1_epi8((char)value);
+    uint64_t mask = 0;
+    int32_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        __m256i eq = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(bytes + i)), v);
+        mask |= (uint64_t)(uint32_t)_mm256_movemask_epi8(eq) << i;
+    }
+    return mask | match_mask_tail(bytes, i, count, value);
+}
+
+void fill_kernels_avx2(SimKernels& k) {
+    k.colorize_row = colorize_row_avx2;
+    k.pack_palette_row = pack_palette_row_scalar;
+    k.count_free_span = count_free_span_avx2;
+    k.find_free_span = find_free_span_avx2;
+    k.clear_bytes = clear_bytes_avx2;
+    k.integrate_gravity = integrate_gravity_avx2;
+    k.match_mask = match_mask_avx2;
+}
+
+// ---- AVX-512 ----
+// 一次 16 格，行尾不足 16 格用掩码读写，不需要标量收尾
+
+TARGET_AVX512
+static void colorize_row_avx512(const uint8_t* ids, const uint8_t* variations, const Color* lut, Color* out, int32_t count) {
+    const int* table = (const int*)lut;
+    const __m512i mask = _mm512_set1_epi32(MATERIAL_MAX_VARIATIONS - 1);
+    for (int32_t i = 0; i < count; i += 16) {
+        __mmask16 lanes = count - i >= 16 ? (__mmask16)0xffff : (__mmask16)((1u << (count - i)) - 1);
+        __m512i id = _mm512_cvtepu8_epi32(_mm_maskz_loadu_epi8(lanes, ids + i));
+        __m512i var = _mm512_cvtepu8_epi32(_mm_maskz_loadu_epi8(lanes, variations + i));
+        __m512i index = _mm512_add_epi32(_mm512_slli_epi32(id, 4), _mm512_and_si512(var, mask));
+        __m512i colors = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), lanes, index, table, 4);
+        _mm512_mask_storeu_epi32(out + i, lanes, colors);
+    }
+}
+
+TARGET_AVX512
+static int32_t count_free_span_avx512(const uint64_t* occupied, const uint64_t* gas, int32_t count,
+                                      uint64_t first_mask, uint64_t last_mask) {
+    return count_free_words(occupied, gas, count, first_mask, last_mask);
+}
+
+TARGET_AVX512
+static int32_t find_free_span_avx512(const uint64_t* occupied, const uint64_t* gas, int32_t count,
+                                     uint64_t first_mask, uint64_t last_mask, bool reverse) {
+    return find_free_words(occupied, gas, count, first_mask, last_mask, reverse);
+}
+
+TARGET_AVX512
+static void clear_bytes_avx512(uint8_t* dst, int32_t count) {
+    const __m512i zero = _mm512_setzero_si512();
+    for (int32_t i = 0; i < count; i += 64) {
+        __mmask64 lanes = count - i >= 64 ? ~0ull : ((1ull << (count - i)) - 1);
+        _mm512_mask_storeu_epi8(dst + i, lanes, zero);
+    }
+}
+
+// 一次 16 格，y 分量用写掩码直接保留 x，行尾同样用掩码
+TARGET_AVX512
+static void integrate_gravity_avx512(const uint8_t* ids, Vec2* velocity, const float* accel, const float* max_speed,
+                                     int32_t count) {
+    const __m512 sign = _mm512_set1_ps(-0.f);
+    const __m512i lo = _mm512_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7);
+    const __m512i hi = _mm512_setr_epi32(8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13, 14, 14, 15, 15);
+    for (int32_t i = 0; i < count; i += 16) {
+        int32_t n = count - i < 16 ? count - i : 16;
+        __m512i id = _mm512_cvtepu8_epi32(_mm_maskz_loadu_epi8((__mmask16)((1u << n) - 1), ids + i));
+        __m512 a = _mm512_i32gather_ps(id, accel, 4);
+        __m512 m = _mm512_i32gather_ps(id, max_speed, 4);
+        float* v = (float*)(velocity + i);
+        for (int32_t half = 0; half < 2; ++half) {
+            int32_t cells = n - half * 8;
+            if (cells <= 0) break;
+            // 只选中存在的格子的 y 分量
+            __mmask16 lanes = (__mmask16)(0xaaaa & (cells >= 8 ? 0xffffu : (1u << (cells * 2)) - 1));
+            __m512i spread = half ? hi : lo;
+            __m512 ha = _mm512_permutexvar_ps(spread, a);
+            __m512 hm = _mm512_permutexvar_ps(spread, m);
+            __m512 old = _mm512_maskz_loadu_ps(lanes, v + half * 16);
+            __m512 r = _mm512_max_ps(_mm512_min_ps(_mm512_add_ps(old, ha), hm), _mm512_xor_ps(hm, sign));
+            _mm512_mask_storeu_ps(v + half * 16, lanes, r);
+        }
+    }
+}
+
+// 比较结果直接就是 64 位掩码
+TARGET_AVX512
+static uint64_t match_mask_avx512(const uint8_t* bytes, int32_t count, uint8_t value) {
+    __mmask64 lanes = count >= 64 ? ~0ull : ((1ull << count) - 1);
+    return _mm512_mask_cmpeq_epi8_mask(lanes, _mm512_maskz_loadu_epi8(lanes, bytes), _mm512_set1_epi8((char)value));
+}
+
+void fill_kernels_avx512(SimKernels& k) {
+    k.colorize_row = colorize_row_avx512;
+    k.pack_palette_row = pack_palette_row_scalar;
+    k.count_free_span = count_free_span_avx512;
+    k.find_free_span = find_free_span_avx512;
+    k.clear_bytes = clear_bytes_avx512;
+    k.integrate_gravity = integrate_gravity_avx512;
+    k.match_mask = match_mask_avx512;
+}
+
+#else
+
+// 非 x86 平台只有标量内核（NEON 交织在标量版本里）
+void fill_kernels_sse42(SimKernels& k) { fill_kernels_scalar(k); }
+void fill_kernels_avx2(SimKernels& k) { fill_kernels_scalar(k); }
+void fill_kernels_avx512(SimKernels& k) { fill_kernels_scalar(k); }
+
+#endif
@@ -0,0 +1,8 @@
+#pragma once
+#include "simd.h"
+
+// 各级别内核的实现，定义见 simd_kernels.cpp，只由 simd.cpp 使用
+void fill_kernels_scalar(SimKernels& k);
+void fill_kernels_sse42(SimKernels& k);
+void fill_kernels_avx2(SimKernels& k);
+void fill_kernels_avx512(SimKernels& k);
@@ -0,0 +1,33 @@
+#include "snapshot.h"
+#include <cstdio>
+#include <spdlog/spdlog.h>
+
+#include "ParticleSim.h"
+
+bool write_snapshot(const std::string& path, const ParticleSimulator& sim) {
+    std::vector<PackedCell> cells;
+    sim.export_packed(cells);
+
+    SnapshotHeader header = {{'P', 'S', 'N', 'P'}, SNAPSHOT_VERSION, sim.width(), sim.height(), sim.seed(), sim.frame()};
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+        spdlog::error("Failed to open snapshot file: {}", path);
+        return false;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(cells.data(), sizeof(PackedCell), cells.size(), file) == cells.size();
+    ok = fclose(file) == 0 && ok;
+    if (!ok) spdlog::error("Failed to write snapshot file: {}", path);
+    return ok;
+}
+
+uint64_t snapshot_hash(const std::vector<PackedCell>& cells) {
+    uint64_t hash = 1469598103934665603ull;
+    for (PackedCell c : cells) {
+        for (int32_t i = 0; i < 8; ++i) {
+            hash = (hash ^ ((c >> (i * 8)) & 0xFF)) * 1099511628211ull;
+        }
+    }
+    return hash;
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "packed_cell.h"
+
+class ParticleSimulator;
+
+#define SNAPSHOT_VERSION 1
+
+// 世界快照文件：文件头之后是 width * height 个 PackedCell（小端，按行存储）
+struct SnapshotHeader {
+    char magic[4];     // "PSNP"
+    uint32_t version;
+    int32_t width;
+    int32_t height;
+    uint64_t seed;
+    uint64_t frame;
+};
+
+bool write_snapshot(const std::string& path, const ParticleSimulator& sim);
+
+// 快照内容的 FNV-1a 哈希，用于比较两次运行的结果是否一致
+uint64_t snapshot_hash(const std::vector<PackedCell>& cells);
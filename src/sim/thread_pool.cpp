@@ -0,0 +1,73 @@
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(uint32_t thread_count) {
+    if (thread_count == 0) thread_count = 1;
+    m_workers.reserve(thread_count - 1);
+    for (uint32_t i = 1; i < thread_count; ++i) {
+        m_workers.emplace_back(&ThreadPool::worker_loop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_start_cv.notify_all();
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::parallel_for(uint32_t count, const std::function<void(uint32_t)>& fn) {
+    if (count == 0) return;
+
+    // 没有工作线程或只有一个任务时直接在当前线程执行
+    if (m_workers.empty() || count == 1) {
+        for (uint32_t i = 0; i < count; ++i) fn(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &fn;
+        m_job_count = count;
+        m_next_index.store(0, std::memory_order_relaxed);
+        m_pending_workers = (uint32_t)m_workers.size();
+        ++m_generation;
+    }
+    m_start_cv.notify_all();
+
+    run_jobs();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done_cv.wait(lock, [this] { return m_pending_workers == 0; });
+    m_job = nullptr;
+}
+
+void ThreadPool::worker_loop() {
+    uint64_t seen_generation = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_start_cv.wait(lock, [&] { return m_stop || m_generation != seen_generation; });
+            if (m_stop) return;
+            seen_generation = m_generation;
+        }
+
+        run_jobs();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_pending_workers == 0) {
+            m_done_cv.notify_one();
+        }
+    }
+}
+
+void ThreadPool::run_jobs() {
+    for (;;) {
+        uint32_t i = m_next_index.fetch_add(1, std::memory_order_relaxed);
+        if (i >= m_job_count) break;
+        (*m_job)(i);
+    }
+}
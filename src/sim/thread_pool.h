@@ -0,0 +1,40 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 固定大小的工作线程池，只提供阻塞式 parallel_for
+// 调用线程本身也参与执行，因此 thread_count 为 1 时不会创建任何工作线程
+class ThreadPool {
+public:
+    explicit ThreadPool(uint32_t thread_count);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    uint32_t thread_count() const { return (uint32_t)m_workers.size() + 1; }
+
+    // 对 [0, count) 内的每个索引调用 fn，所有任务完成后才返回
+    void parallel_for(uint32_t count, const std::function<void(uint32_t)>& fn);
+
+private:
+    void worker_loop();
+    void run_jobs();
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_start_cv;
+    std::condition_variable m_done_cv;
+
+    const std::function<void(uint32_t)>* m_job = nullptr;
+    std::atomic<uint32_t> m_next_index { 0 };
+    uint32_t m_job_count = 0;
+    uint32_t m_pending_workers = 0;
+    uint64_t m_generation = 0;
+    bool m_stop = false;
+};
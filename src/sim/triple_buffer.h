@@ -0,0 +1,57 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+
+// 单写单读的无锁三缓冲。
+// 写入端总有一个独占的后台缓冲区，读取端总有一个独占的前台缓冲区，
+// 第三个缓冲区在两者之间交换。双方都不会等待对方：
+// 写入端发布得比读取快时，没被取走的旧帧直接被覆盖；读取端取得比写入快时，继续使用当前帧。
+// T 是一整帧的数据，三个槽位循环复用。
+template <typename T>
+class TripleBuffer {
+public:
+    // 初始化时逐个设置槽位，只能在开始读写之前调用
+    T& slot(uint32_t i) { return m_slots[i]; }
+
+    // 写入端：当前可以写的槽位，里面是之前某一帧的旧数据
+    T& write_slot() { return m_slots[m_back]; }
+
+    // 写入端：write_slot 是第几个槽位，用来给每个槽位记录各自的状态
+    uint32_t write_index() const { return m_back; }
+
+    // 写入端：发布 write_slot 中写好的帧，并换回一个空闲槽位
+    void publish()
+    {
+        m_back = m_middle.exchange(m_back | FRESH_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // 写入端：上一次发布的帧是否已经被读取端取走（还没发布过时也返回 true）。
+    // 返回 false 时读取端仍可能在下一次 publish 之前取走它
+    bool published_taken() const
+    {
+        return (m_middle.load(std::memory_order_acquire) & FRESH_BIT) == 0;
+    }
+
+    // 读取端：有新帧时换到最新的一帧。返回的指针在下一次 acquire 之前有效，
+    // 还没有发布过任何帧时返回 nullptr。fresh 不为空时表示这次是否拿到了新帧
+    const T* acquire(bool* fresh = nullptr)
+    {
+        bool is_fresh = (m_middle.load(std::memory_order_relaxed) & FRESH_BIT) != 0;
+        if (is_fresh) {
+            m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & INDEX_MASK;
+            m_has_frame = true;
+        }
+        if (fresh) *fresh = is_fresh;
+        return m_has_frame ? &m_slots[m_front] : nullptr;
+    }
+
+private:
+    static constexpr uint32_t INDEX_MASK = 3;
+    static constexpr uint32_t FRESH_BIT = 4;
+
+    T m_slots[3];
+    uint32_t m_back = 0;                    // 只由写入端访问
+    uint32_t m_front = 2;                   // 只由读取端访问
+    bool m_has_frame = false;               // 只由读取端访问
+    std::atomic<uint32_t> m_middle { 1 };   // 交换位：槽位下标 | FRESH_BIT
+};
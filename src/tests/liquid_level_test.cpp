@@ -0,0 +1,63 @@
+// 液面测试：在石头水池的一侧持续倒水，停止倒水后液面必须在限定的 tick 数内整体变平（最高和最低列相差不超过一行），
+// 并且所有区块进入休眠。宽水池的液面超出液体的搜索范围，检验落点方向按整行传递。
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+#include "ParticleSim.h"
+#include "sim/material_registry.h"
+
+static bool lake_levels(int32_t w, int32_t h, uint32_t pour_ticks, uint32_t settle_ticks)
+{
+    ParticleSimulator sim(w, h);
+    sim.set_thread_count(2);
+    sim.set_seed(1);
+    sim.paint_rect(0, h - 4, w - 1, h - 1, mat_id_stone);
+    sim.paint_rect(0, 0, 3, h - 5, mat_id_stone);
+    sim.paint_rect(w - 4, 0, w - 1, h - 5, mat_id_stone);
+
+    for (uint32_t i = 0; i < pour_ticks; ++i) {
+        sim.paint_rect(4, 0, 40, 1, mat_id_water);
+        sim.step();
+    }
+
+    uint32_t ticks = 0;
+    while (ticks < settle_ticks && sim.awake_chunk_count() != 0) {
+        sim.step();
+        ++ticks;
+    }
+    if (sim.awake_chunk_count() != 0) {
+        spdlog::error("{}x{}: {} chunks still awake {} ticks after pouring stopped", w, h, sim.awake_chunk_count(), ticks);
+        return false;
+    }
+
+    // 每个内部列最上面的水所在的行
+    std::vector<PackedCell> cells;
+    sim.export_packed(cells);
+    int32_t top_min = h, top_max = -1;
+    for (int32_t x = 4; x < w - 4; ++x) {
+        int32_t y = 0;
+        while (y < h - 4 && packed_id(cells[y * w + x]) != mat_id_water) ++y;
+        top_min = std::min(top_min, y);
+        top_max = std::max(top_max, y);
+    }
+    if (top_max >= h - 4) {
+        spdlog::error("{}x{}: some columns of the basin hold no water", w, h);
+        return false;
+    }
+    if (top_max - top_min > 1) {
+        spdlog::error("{}x{}: surface spans rows {}..{} after settling", w, h, top_min, top_max);
+        return false;
+    }
+    spdlog::info("{}x{}: surface at rows {}..{}, asleep {} ticks after pouring stopped", w, h, top_min, top_max, ticks);
+    return true;
+}
+
+int main()
+{
+    bool ok = true;
+    ok &= lake_levels(160, 128, 100, 3000);
+    ok &= lake_levels(512, 128, 400, 3000);
+    return ok ? 0 : 1;
+}